@@ -4,6 +4,7 @@
 #include <string>
 #include <variant>
 #include <memory>
+#include <cstddef>
 #include "tile.h"
 #include "error.h"
 
@@ -11,6 +12,14 @@ namespace tess {
 
     using result = std::variant<std::vector<tile>, error>;
 
+    // how the memoized calls of an execution were answered; loaded counts the hits
+    // read from a memo file.
+    struct memo_stats {
+        std::size_t hits = 0;
+        std::size_t loaded = 0;
+        std::size_t misses = 0;
+    };
+
     class script
     {
         friend class tessera_impl;
@@ -19,8 +28,19 @@ namespace tess {
         script() {}
         static std::variant<tess::script, tess::error> parse(const std::string& script);
         const std::vector<std::string>& parameters() const;
+        // can be called from several threads at once. Each execution runs on a state of
+        // its own, and the tiles it returns keep that state alive.
         result execute(const std::vector<std::string>& args) const;
 
+        // keeps memoized results in the file at path, so that executions of this script
+        // in later runs start with the results of earlier ones.
+        void set_memo_file(const std::string& path) const;
+        // of the last execution to finish.
+        memo_stats memo_statistics() const;
+        // evaluates the operands of a lay that call functions, and do not refer to each
+        // other, on the shared thread pool, each in a heap of its own. Off by default.
+        void set_parallel(bool parallel) const;
+
         template <typename... T>
         result execute(T&&... a) const {
             return execute({ std::forward<T>(a)... });
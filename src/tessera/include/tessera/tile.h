@@ -46,6 +46,7 @@ namespace tess {
 		using impl_type = detail::vertex_impl;
 	private:
 		const impl_type* impl_;
+		std::shared_ptr<const void> owner_;
 	};
 
 	class edge : public detail::property_container<edge>  {
@@ -57,6 +58,7 @@ namespace tess {
 		using impl_type = detail::edge_impl;
 	private:
 		const impl_type* impl_;
+		std::shared_ptr<const void> owner_;
 	};
 
 	class tile : public detail::property_container<tile> {
@@ -68,6 +70,9 @@ namespace tess {
 		using impl_type = detail::tile_impl;
 	private:
 		const impl_type* impl_;
+		// the execution that made the tile; its heap lives as long as any of its tiles,
+		// edges or vertices do.
+		std::shared_ptr<const void> owner_;
 	};
 
 }
\ No newline at end of file
@@ -21,5 +21,6 @@ namespace tess {
 		using impl_type = detail::patch_impl;
 	private:
 		const impl_type* impl_;
+		std::shared_ptr<const void> owner_;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,502 @@
+#include "bytecode.h"
+#include "ops.h"
+#include "execution_state.h"
+#include "evaluation_context.h"
+#include "lambda_impl.h"
+#include "tile_impl.h"
+#include "tile_patch_impl.h"
+#include "cluster.h"
+#include "field_ref.h"
+#include "variant_util.h"
+#include "thread_pool.h"
+#include "tessera/error.h"
+#include <sstream>
+#include <algorithm>
+#include <iterator>
+#include <unordered_map>
+#include <any>
+
+namespace {
+
+    const char* opcode_name(tess::stack_machine::opcode op)
+    {
+        using tess::stack_machine::opcode;
+        switch (op) {
+            case opcode::push_const: return "push_const";
+            case opcode::get_var: return "get_var";
+            case opcode::assign: return "assign";
+            case opcode::push_frame: return "push_frame";
+            case opcode::pop_frame: return "pop_frame";
+            case opcode::set_dependencies: return "set_dependencies";
+            case opcode::make_lambda: return "make_lambda";
+            case opcode::push_context: return "push_context";
+            case opcode::pop_context: return "pop_context";
+            case opcode::call: return "call";
+            case opcode::memoize: return "memoize";
+            case opcode::branch: return "branch";
+            case opcode::get_ary_item: return "get_ary_item";
+            case opcode::iterate_begin: return "iterate_begin";
+            case opcode::iterate_next: return "iterate_next";
+            case opcode::get_field: return "get_field";
+            case opcode::set_field: return "set_field";
+            case opcode::lay: return "lay";
+            case opcode::call_native: return "call_native";
+            case opcode::fork: return "fork";
+        }
+        return "?";
+    }
+
+    // instructions the machine runs that are not part of any program.
+    using tess::stack_machine::instruction;
+    using tess::stack_machine::opcode;
+
+    const instruction k_call_parameterless[] = { { opcode::call, 0, 0 }, { opcode::pop_context, 0, 0 } };
+    const instruction k_memoize[] = { { opcode::memoize, 0, 0 } };
+
+}
+
+std::string tess::stack_machine::program::to_string() const
+{
+    std::stringstream ss;
+    for (int i = 0; i < static_cast<int>(blocks.size()); ++i) {
+        ss << "block " << i << ((i == entry) ? " (entry)" : "") << ":\n";
+        for (const auto& inst : blocks[i]) {
+            ss << "    " << opcode_name(inst.op) << " " << inst.a << " " << inst.b;
+            switch (inst.op) {
+                case opcode::push_const:
+                    ss << "    ; " << tess::to_string(constants[inst.a]);
+                    break;
+                case opcode::get_var:
+                    ss << "    ; " << variables[inst.a].to_string();
+                    break;
+                case opcode::get_field:
+                    ss << "    ; " << strings[inst.a];
+                    break;
+                case opcode::call_native:
+                    ss << "    ; " << natives[inst.a].name;
+                    break;
+                case opcode::make_lambda:
+                    ss << "    ; block " << lambdas[inst.a].body;
+                    break;
+                default:
+                    break;
+            }
+            ss << "\n";
+        }
+    }
+    return ss.str();
+}
+
+/*------------------------------------------------------------------------------*/
+
+tess::stack_machine::assembler::assembler() :
+    program_(std::make_shared<program>())
+{
+}
+
+std::shared_ptr<const tess::stack_machine::program> tess::stack_machine::assembler::assemble(const std::vector<item>& entry)
+{
+    program_->entry = add_block(entry);
+    auto prog = program_;
+    program_ = std::make_shared<program>();
+    return prog;
+}
+
+int tess::stack_machine::assembler::add_block(const std::vector<item>& items)
+{
+    // nested blocks are added while the enclosing block is being emitted.
+    std::vector<instruction> code;
+    std::swap(code, code_);
+    for (const auto& it : items) {
+        it.visit(
+            overloaded{
+                [&](const op_ptr& op) {
+                    op->emit(*this);
+                },
+                [&](const value_& val) {
+                    emit(opcode::push_const, add_constant(val));
+                },
+                [&](const error& e) {
+                    throw e;
+                }
+            }
+        );
+    }
+    std::swap(code, code_);
+
+    program_->blocks.push_back(std::move(code));
+    return static_cast<int>(program_->blocks.size() - 1);
+}
+
+void tess::stack_machine::assembler::append(int block, opcode op, int a, int b)
+{
+    program_->blocks[block].push_back({ op, a, b });
+}
+
+int tess::stack_machine::assembler::block_size(int block) const
+{
+    return static_cast<int>(program_->blocks[block].size());
+}
+
+void tess::stack_machine::assembler::emit(opcode op, int a, int b)
+{
+    code_.push_back({ op, a, b });
+}
+
+int tess::stack_machine::assembler::add_constant(const value_& val)
+{
+    program_->constants.push_back(val);
+    return static_cast<int>(program_->constants.size() - 1);
+}
+
+int tess::stack_machine::assembler::add_variable(const variable& var)
+{
+    program_->variables.push_back(var);
+    return static_cast<int>(program_->variables.size() - 1);
+}
+
+int tess::stack_machine::assembler::add_variable_list(const std::vector<variable>& vars)
+{
+    program_->variable_lists.push_back(vars);
+    return static_cast<int>(program_->variable_lists.size() - 1);
+}
+
+int tess::stack_machine::assembler::add_string(const std::string& str)
+{
+    program_->strings.push_back(str);
+    return static_cast<int>(program_->strings.size() - 1);
+}
+
+int tess::stack_machine::assembler::add_native(const std::string& name, const native_func& func)
+{
+    program_->natives.push_back({ name, func });
+    return static_cast<int>(program_->natives.size() - 1);
+}
+
+int tess::stack_machine::assembler::add_lambda(const lambda_template& lambda)
+{
+    program_->lambdas.push_back(lambda);
+    return static_cast<int>(program_->lambdas.size() - 1);
+}
+
+int tess::stack_machine::assembler::add_fork(const std::vector<task_template>& tasks)
+{
+    program_->forks.push_back(tasks);
+    return static_cast<int>(program_->forks.size() - 1);
+}
+
+/*------------------------------------------------------------------------------*/
+
+tess::stack_machine::machine::machine(bool parallel) :
+    parallel_(parallel)
+{
+}
+
+tess::value_ tess::stack_machine::machine::run(execution_state& state, const std::shared_ptr<const program>& prog)
+{
+    return run(state, state.create_eval_context(), prog, prog->entry);
+}
+
+tess::value_ tess::stack_machine::machine::run(execution_state& state, evaluation_context&& ctxt, const std::shared_ptr<const program>& prog, int block)
+{
+    auto& contexts = state.context_stack();
+    contexts.push(std::move(ctxt));
+
+    programs_ = { prog };
+    code_.clear();
+    operands_.clear();
+    memo_keys_.clear();
+    enter(prog.get(), block);
+
+    while (!code_.empty()) {
+        auto& frame = code_.back();
+        if (frame.pc == frame.end) {
+            code_.pop_back();
+            continue;
+        }
+        // frame is invalidated by anything that enters a block.
+        const auto& inst = *frame.pc++;
+        const auto& prog = *frame.prog;
+
+        switch (inst.op) {
+            case opcode::push_const:
+                operands_.push_back(prog.constants[inst.a]);
+                break;
+
+            case opcode::get_var: {
+                auto value = get_variable(contexts.top(), prog.variables[inst.a]);
+                if (inst.b && std::holds_alternative<const_lambda_root_ptr>(value) &&
+                        std::get<const_lambda_root_ptr>(value)->parameters().empty()) {
+                    contexts.push(state.create_eval_context());
+                    enter(std::begin(k_call_parameterless), std::end(k_call_parameterless), &prog);
+                }
+                operands_.push_back(std::move(value));
+                break;
+            }
+
+            case opcode::assign:
+                assign_variables(contexts.top(), prog.variable_lists[inst.a], pop());
+                break;
+
+            case opcode::push_frame:
+                if (contexts.empty())
+                    throw tess::error("context stack underflow");
+                contexts.top().push_scope(scope_frame(inst.a));
+                break;
+
+            case opcode::pop_frame:
+                if (contexts.empty())
+                    throw tess::error("context stack underflow");
+                if (contexts.top().empty())
+                    throw tess::error("eval context underflow");
+                contexts.top().pop_scope();
+                break;
+
+            case opcode::set_dependencies:
+                set_dependencies(contexts.top(), prog.variable_lists[inst.a]);
+                break;
+
+            case opcode::make_lambda: {
+                const auto& lambda = prog.lambdas[inst.a];
+                auto& ctxt = contexts.top();
+                auto func = ctxt.allocator().make_mutable<const_lambda_root_ptr>(
+                    lambda.id, lambda.parameters, code_ref{ prog.shared_from_this(), lambda.body }, lambda.dependencies
+                );
+                capture_variables(ctxt, func, prog.variable_lists[lambda.captures]);
+                operands_.push_back(tess::make_value(func));
+                break;
+            }
+
+            case opcode::push_context:
+                contexts.push(state.create_eval_context());
+                break;
+
+            case opcode::pop_context:
+                contexts.pop();
+                break;
+
+            case opcode::call:
+                call(contexts, inst.a);
+                break;
+
+            case opcode::memoize: {
+                contexts.memos().insert(std::move(memo_keys_.back()), operands_.back());
+                memo_keys_.pop_back();
+                break;
+            }
+
+            case opcode::branch:
+                enter(&prog, std::get<bool>(pop()) ? inst.a : inst.b);
+                break;
+
+            case opcode::get_ary_item: {
+                auto ary = pop();
+                auto index = std::get<tess::number>(pop());
+                operands_.push_back(tess::get_ary_item(ary, tess::to_int(index)));
+                break;
+            }
+
+            case opcode::iterate_begin: {
+                // the placeholders for the destination and the current item are the ones
+                // the reference interpreter's first iterate_op expects.
+                auto src = pop();
+                auto dst = pop();
+                pop();
+                if (std::get<tess::const_cluster_root_ptr>(src)->get_ary_count() == 0) {
+                    operands_.push_back(std::move(dst));
+                    break;
+                }
+                auto& ctxt = contexts.top();
+                auto empty = ctxt.allocator().make_const<const_cluster_root_ptr>(std::vector<value_>{});
+                if (start_iteration(ctxt, prog.variables[inst.a], src, value_{ empty }, 0))
+                    enter(&prog, inst.b);
+                break;
+            }
+
+            case opcode::iterate_next: {
+                auto curr_item = pop();
+                auto index = tess::to_int(std::get<tess::number>(pop()));
+                auto src = pop();
+                auto dst = pop();
+                get_mutable<tess::const_cluster_root_ptr>(dst)->push_value(curr_item);
+                if (start_iteration(contexts.top(), prog.variables[inst.a], src, std::move(dst), index + 1))
+                    code_.back().pc -= inst.b;
+                break;
+            }
+
+            case opcode::get_field: {
+                auto val = pop();
+                const auto& field = prog.strings[inst.a];
+                if (!inst.b)
+                    operands_.push_back(tess::get_field(val, contexts.top().allocator(), field));
+                else
+                    operands_.push_back(value_{ std::make_shared<field_ref_impl>(val, field) });
+                break;
+            }
+
+            case opcode::set_field: {
+                auto operands = top(inst.a + 1);
+                set_fields({ &operands.front() + 1, inst.a }, operands.back());
+                drop(inst.a + 1);
+                break;
+            }
+
+            case opcode::lay: {
+                auto result = lay(contexts.top(), prog.variable_lists[inst.a], top(2 * inst.b));
+                drop(2 * inst.b);
+                operands_.push_back(std::move(result));
+                break;
+            }
+
+            case opcode::call_native: {
+                // natives read their arguments in place; only the result is written.
+                auto result = prog.natives[inst.a].func(contexts.top().allocator(), top(inst.b));
+                drop(inst.b);
+                operands_.push_back(std::move(result));
+                break;
+            }
+
+            case opcode::fork: {
+                auto result = parallel_ ? fork(contexts.top(), prog, prog.forks[inst.a]) : std::nullopt;
+                if (result)
+                    operands_.push_back(std::move(*result));
+                else
+                    enter(&prog, inst.b);
+                break;
+            }
+        }
+    }
+
+    return pop();
+}
+
+std::optional<tess::value_> tess::stack_machine::machine::fork(evaluation_context& ctxt, const program& prog, const std::vector<task_template>& tasks)
+{
+    // each task gets a heap of its own holding copies of the variables it reads, so
+    // the tasks share nothing with each other or with this machine while they run.
+    int n = static_cast<int>(tasks.size());
+    std::vector<execution_state> states(n);
+    std::vector<evaluation_context> task_contexts;
+    task_contexts.reserve(n);
+    try {
+        for (int i = 0; i < n; ++i) {
+            const auto& inputs = prog.variable_lists[tasks[i].inputs];
+            int depth = 0;
+            for (const auto& var : inputs)
+                depth = std::max(depth, var.depth() + 1);
+            std::vector<scope_frame> frames(depth);
+            std::unordered_map<obj_id, std::any> copies;
+            for (const auto& var : inputs) {
+                auto val = ctxt.get(var.depth(), var.slot());
+                if (val)
+                    frames[var.depth()].set(var.slot(), clone_value(states[i].allocator(), copies, *val));
+            }
+            task_contexts.push_back(states[i].create_eval_context());
+            for (auto frame = frames.rbegin(); frame != frames.rend(); ++frame)
+                task_contexts.back().push_scope(std::move(*frame));
+        }
+    } catch (const tess::error&) {
+        return std::nullopt;
+    }
+
+    std::vector<value_> results(n);
+    thread_pool::shared().parallel_for(n,
+        [&](int i) {
+            machine task;
+            results[i] = task.run(states[i], std::move(task_contexts[i]), prog.shared_from_this(), tasks[i].block);
+            states[i].allocator().collect();
+        }
+    );
+
+    // the results move into this heap as they are, along with whatever else the tasks'
+    // heaps still hold; that goes at this heap's next collection.
+    for (auto& state : states)
+        ctxt.allocator().adopt(state.allocator());
+    return value_{ ctxt.allocator().make_const<const_cluster_root_ptr>(results) };
+}
+
+void tess::stack_machine::machine::enter(const instruction* begin, const instruction* end, const program* prog)
+{
+    // a frame with nothing left to run is not a return address; reusing it keeps 
+    // tail calls and branches from growing the stack.
+    if (!code_.empty() && code_.back().pc == code_.back().end)
+        code_.back() = { begin, end, prog };
+    else
+        code_.push_back({ begin, end, prog });
+}
+
+void tess::stack_machine::machine::enter(const program* prog, int block)
+{
+    const auto& code = prog->blocks[block];
+    enter(code.data(), code.data() + code.size(), prog);
+}
+
+tess::value_ tess::stack_machine::machine::pop()
+{
+    if (operands_.empty())
+        throw tess::error("operand stack underflow.");
+    auto val = std::move(operands_.back());
+    operands_.pop_back();
+    return val;
+}
+
+tess::stack_machine::args_view tess::stack_machine::machine::top(int n) const
+{
+    if (n > static_cast<int>(operands_.size()))
+        throw tess::error("operand stack underflow.");
+    return { operands_.data() + operands_.size(), n };
+}
+
+void tess::stack_machine::machine::drop(int n)
+{
+    operands_.resize(operands_.size() - n);
+}
+
+void tess::stack_machine::machine::call(context_stack& contexts, int num_args)
+{
+    // the function is on top with its arguments under it.
+    auto operands = top(num_args + 1);
+    if (!std::holds_alternative<const_lambda_root_ptr>(operands.front()))
+        throw tess::error("Attempted to evaluate non-lambda");
+    auto func = std::get<const_lambda_root_ptr>(operands.front());
+    args_view args(&operands.front(), num_args);
+
+    memo_key key;
+    auto memo_val = contexts.memos().find(func, args, key);
+    if (memo_val) {
+        auto val = *memo_val;
+        drop(num_args + 1);
+        operands_.push_back(std::move(val));
+        return;
+    }
+
+    contexts.top().push_scope(make_call_frame(func, args));
+    drop(num_args + 1);
+
+    const auto& code = func->code();
+    if (!code.prog)
+        throw tess::error("attempted to call a function that has no compiled body");
+    if (std::find(programs_.begin(), programs_.end(), code.prog) == programs_.end())
+        programs_.push_back(code.prog);
+
+    memo_keys_.push_back(std::move(key));
+    enter(std::begin(k_memoize), std::end(k_memoize), code.prog.get());
+    enter(code.prog.get(), code.block);
+}
+
+bool tess::stack_machine::machine::start_iteration(evaluation_context& ctxt, const variable& var, const value_& src, value_ dst, int index)
+{
+    auto n = std::get<tess::const_cluster_root_ptr>(src)->get_ary_count();
+    if (index >= n) {
+        operands_.push_back(std::move(dst));
+        return false;
+    }
+
+    ctxt.peek().set(var.slot(), tess::get_ary_item(src, index));
+
+    // the loop state stays on the operand stack under the item the body leaves.
+    operands_.push_back(std::move(dst));
+    operands_.push_back(src);
+    operands_.push_back(value_{ tess::number(index) });
+    return true;
+}
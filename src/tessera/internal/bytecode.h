@@ -0,0 +1,159 @@
+#pragma once
+
+#include "value.h"
+#include "stack_machine.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <functional>
+#include <cstdint>
+#include <optional>
+
+namespace tess {
+
+    class gc_heap;
+    class execution_state;
+
+    namespace stack_machine
+    {
+        // operands a and b are indices into the pools of the program the instruction
+        // belongs to unless noted otherwise.
+        enum class opcode : uint8_t {
+            push_const,         // a: constant
+            get_var,            // a: variable, b: nonzero to call parameterless lambdas
+            assign,             // a: variable list
+            push_frame,         // a: number of slots
+            pop_frame,
+            set_dependencies,   // a: variable list of the visible variables
+            make_lambda,        // a: lambda
+            push_context,
+            pop_context,
+            call,               // a: number of arguments
+            memoize,
+            branch,             // a: then block, b: else block
+            get_ary_item,
+            iterate_begin,      // a: index variable, b: body block
+            iterate_next,       // a: index variable, b: number of instructions back to the start of the body
+            get_field,          // a: field name, b: nonzero to get a reference
+            set_field,          // a: number of fields
+            lay,                // a: variable list of the layees, b: number of mappings
+            call_native,        // a: native function, b: number of arguments
+            fork                // a: fork, b: block running the fork's tasks one after another
+        };
+
+        struct instruction {
+            opcode op;
+            int a;
+            int b;
+        };
+
+        struct native_function {
+            std::string name;
+            native_func func;
+        };
+
+        // an operand of a fork: a block leaving one value, and the variables it reads.
+        struct task_template {
+            int block;
+            int inputs;         // variable list
+        };
+
+        struct lambda_template {
+            unsigned int id;
+            std::vector<std::string> parameters;
+            std::vector<std::string> dependencies;
+            int captures;
+            int body;
+        };
+
+        class program : public std::enable_shared_from_this<program> {
+        public:
+            std::vector<value_> constants;
+            std::vector<variable> variables;
+            std::vector<std::vector<variable>> variable_lists;
+            std::vector<std::string> strings;
+            std::vector<native_function> natives;
+            std::vector<lambda_template> lambdas;
+            std::vector<std::vector<task_template>> forks;
+            std::vector<std::vector<instruction>> blocks;
+            int entry = -1;
+
+            std::string to_string() const;
+        };
+
+        // a lambda body: a block of the program the lambda was made by.
+        struct code_ref {
+            std::shared_ptr<const program> prog;
+            int block = -1;
+        };
+
+        // lowers the op items compile() produces into a program. Each op emits its own
+        // instructions, see op::emit.
+        class assembler {
+        public:
+            assembler();
+            std::shared_ptr<const program> assemble(const std::vector<item>& entry);
+
+            int add_block(const std::vector<item>& items);
+            void append(int block, opcode op, int a = 0, int b = 0);
+            int block_size(int block) const;
+            void emit(opcode op, int a = 0, int b = 0);
+            int add_constant(const value_& val);
+            int add_variable(const variable& var);
+            int add_variable_list(const std::vector<variable>& vars);
+            int add_string(const std::string& str);
+            int add_native(const std::string& name, const native_func& func);
+            int add_lambda(const lambda_template& lambda);
+            int add_fork(const std::vector<task_template>& tasks);
+
+        private:
+            std::shared_ptr<program> program_;
+            std::vector<instruction> code_;
+        };
+
+        class machine
+        {
+        public:
+            // a parallel machine runs the tasks of a fork on the shared thread pool, each on
+            // an execution state of its own; otherwise they run one after another. The
+            // tasks themselves run on machines that are not parallel.
+            explicit machine(bool parallel = false);
+
+            // runs the op items on the main stack of the state. This is the reference
+            // interpreter; a program assembled from the same items must give the same result.
+            value_ run(execution_state& state);
+
+            value_ run(execution_state& state, const std::shared_ptr<const program>& prog);
+            // runs a block of prog in ctxt, a context of state.
+            value_ run(execution_state& state, evaluation_context&& ctxt, const std::shared_ptr<const program>& prog, int block);
+
+        private:
+            // the rest of a block still to run. Blocks are never copied: calls, branches and
+            // loops push a code_frame and the frames under it are the return addresses.
+            struct code_frame {
+                const instruction* pc;
+                const instruction* end;
+                const program* prog;
+            };
+
+            void enter(const instruction* begin, const instruction* end, const program* prog);
+            void enter(const program* prog, int block);
+            value_ pop();
+            args_view top(int n) const;
+            void drop(int n);
+            void call(context_stack& contexts, int num_args);
+            bool start_iteration(evaluation_context& ctxt, const variable& var, const value_& src, value_ dst, int index);
+            std::optional<value_> fork(evaluation_context& ctxt, const program& prog, const std::vector<task_template>& tasks);
+
+            // a lambda made by an earlier program can be called after the lambda itself
+            // is gone, so the machine keeps the programs it has entered alive.
+            std::vector<std::shared_ptr<const program>> programs_;
+
+            std::vector<code_frame> code_;
+            std::vector<value_> operands_;
+            std::vector<memo_key> memo_keys_;
+            bool parallel_;
+        };
+
+    }
+}
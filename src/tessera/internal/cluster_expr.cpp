@@ -14,20 +14,20 @@ tess::cluster_expr::cluster_expr(const std::vector<expr_ptr>& exprs) :
 {
 }
 
-void tess::cluster_expr::compile(stack_machine::stack& stack) const
+void tess::cluster_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
     int n = static_cast<int>(exprs_.size());
     stack.push(
         std::make_shared<val_func_op>(
             n,
-            [](gc_heap& a, const std::vector<value_>& values)->value_ {
-                return value_(a.make_const<const_cluster_root_ptr>(values));
+            [](gc_heap& a, stack_machine::args_view values)->value_ {
+                return value_(a.make_const<const_cluster_root_ptr>(std::vector<value_>(values.begin(), values.end())));
             },
             "<make_cluster " + std::to_string(n) + ">"
         )
     );
     for (auto e : exprs_)
-        e->compile(stack);
+        e->compile(stack, scope);
 }
 
 tess::expr_ptr tess::cluster_expr::simplify() const
@@ -67,12 +67,12 @@ tess::num_range_expr::num_range_expr(const std::tuple<expr_ptr, expr_ptr>& tup)
 {
 }
 
-void tess::num_range_expr::compile(stack_machine::stack& stack) const
+void tess::num_range_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
     stack.push(
         std::make_shared<val_func_op>(
             2,
-            [](gc_heap& a, const std::vector<value_>& values)->value_ {
+            [](gc_heap& a, stack_machine::args_view values)->value_ {
                 int from = to_int(std::get<number>( values[0] ));
                 int to = to_int(std::get<number>( values[1] ));
                 int n = (to >= from) ? to - from + 1 : 0;
@@ -90,8 +90,8 @@ void tess::num_range_expr::compile(stack_machine::stack& stack) const
             "<make_range>"
         )
     );
-    from_->compile(stack);
-    to_->compile(stack);
+    from_->compile(stack, scope);
+    to_->compile(stack, scope);
 }
 
 tess::expr_ptr tess::num_range_expr::simplify() const
@@ -133,16 +133,23 @@ std::string tess::cluster_comprehension_expr::to_string() const
         " )";
 }
 
-void tess::cluster_comprehension_expr::compile(stack_machine::stack& stack) const
+void tess::cluster_comprehension_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
+    // the range is evaluated in the new frame before the index variable is assigned.
+    scope.push_frame();
+    stack_machine::stack range;
+    range_expr_->compile(range, scope);
+    stack_machine::variable index_var(var_, 0, scope.declare(var_));
     stack_machine::stack body;
-    item_expr_->compile(body);
+    item_expr_->compile(body, scope);
+
     stack.push(std::make_shared<pop_frame_op>());
-    stack.push(std::make_shared<iterate_op>(var_, -1, body.pop_all()));
-    range_expr_->compile(stack);
+    stack.push(std::make_shared<iterate_op>(index_var, -1, body.pop_all()));
+    stack.push(range.pop_all());
     stack.push(value_());
     stack.push(value_());
-    stack.push(std::make_shared<push_frame_op>());
+    stack.push(std::make_shared<push_frame_op>(scope.frame_size()));
+    scope.pop_frame();
 }
 
 tess::expr_ptr tess::cluster_comprehension_expr::simplify() const
@@ -164,6 +171,99 @@ void tess::cluster_comprehension_expr::get_dependencies(std::unordered_set<std::
     range_expr_->get_dependencies(dependencies);
 }
 
+tess::fork_expr::fork_expr(const std::vector<expr_ptr>& exprs) :
+    exprs_(exprs)
+{
+}
+
+void tess::fork_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
+{
+    int n = static_cast<int>(exprs_.size());
+    std::vector<std::vector<stack_machine::item>> operands;
+    std::vector<std::vector<stack_machine::variable>> inputs;
+    bool calls = true;
+    for (auto e : exprs_) {
+        stack_machine::stack code;
+        e->compile(code, scope);
+        operands.push_back(code.pop_all());
+        calls = calls && std::any_of(operands.back().begin(), operands.back().end(),
+            [](const stack_machine::item& item) {
+                auto op = std::get_if<stack_machine::op_ptr>(&item);
+                return op && std::dynamic_pointer_cast<call_func>(*op);
+            }
+        );
+
+        std::unordered_set<std::string> dependencies;
+        e->get_dependencies(dependencies);
+        inputs.emplace_back();
+        for (const auto& dependency : dependencies) {
+            auto var = scope.resolve(dependency);
+            if (var.is_resolved())
+                inputs.back().push_back(var);
+        }
+    }
+
+    // the operands run first to last, each followed by a clone of its value.
+    stack_machine::stack serial;
+    serial.push(
+        std::make_shared<val_func_op>(
+            n,
+            [](gc_heap& a, stack_machine::args_view values)->value_ {
+                // the first operand's value is the deepest.
+                std::vector<value_> cluster;
+                for (int i = values.size() - 1; i >= 0; --i)
+                    cluster.push_back(values[i]);
+                return value_(a.make_const<const_cluster_root_ptr>(cluster));
+            },
+            "<make_cluster " + std::to_string(n) + ">"
+        )
+    );
+    for (int i = n - 1; i >= 0; --i) {
+        serial.push(
+            std::make_shared<one_param_op>(
+                [](gc_heap& a, const value_& v)->value_ {
+                    return tess::clone_value(a, v);
+                },
+                "clone"
+            )
+        );
+        serial.push(operands[i]);
+    }
+
+    // forking operands that do not call anything costs more than it could save.
+    if (calls)
+        stack.push(std::make_shared<fork_op>(operands, inputs, serial.pop_all()));
+    else
+        stack.push(serial.pop_all());
+}
+
+tess::expr_ptr tess::fork_expr::simplify() const
+{
+    std::vector<expr_ptr> simplified(exprs_.size());
+    std::transform(exprs_.begin(), exprs_.end(), simplified.begin(),
+         [](expr_ptr e) {
+             return e->simplify();
+         }
+    );
+    return std::make_shared<tess::fork_expr>(simplified);
+}
+
+std::string tess::fork_expr::to_string() const
+{
+    std::stringstream ss;
+    for (const auto& e : exprs_)
+        ss << e->to_string() << " ";
+    return "( fork " + ss.str() + ")";
+}
+
+void tess::fork_expr::get_dependencies(std::unordered_set<std::string>& dependencies) const
+{
+    for (const auto& e : exprs_)
+        e->get_dependencies(dependencies);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+
 tess::map_expr::map_expr(expr_ptr lambda, expr_ptr cluster) :
     lambda_(lambda), cluster_(cluster)
 {
@@ -174,7 +274,7 @@ std::string tess::map_expr::to_string() const
     return std::string();
 }
 
-void tess::map_expr::compile(stack_machine::stack& stack) const
+void tess::map_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
     //TODO
 }
@@ -9,7 +9,7 @@ namespace tess {
         std::vector<expr_ptr> exprs_;
     public:
         cluster_expr(const std::vector<expr_ptr>& exprs);
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         expr_ptr simplify() const override;
         std::string to_string() const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
@@ -23,7 +23,7 @@ namespace tess {
         num_range_expr(expr_ptr from, expr_ptr to);
         num_range_expr(const std::tuple<expr_ptr, expr_ptr>& tup);
         std::string to_string() const override;
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         expr_ptr simplify() const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
     };
@@ -38,11 +38,26 @@ namespace tess {
         cluster_comprehension_expr(expr_ptr ex, const std::string& var, expr_ptr range_expr);
         cluster_comprehension_expr( std::tuple<expr_ptr, std::string, expr_ptr> tup);
         std::string to_string() const override;
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         expr_ptr simplify() const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
     };
 
+    // a cluster of independent expressions, each evaluated on a copy of what it reads.
+    // When every operand calls a function, a parallel machine may evaluate them at once,
+    // see fork_op.
+    class fork_expr : public expression
+    {
+    private:
+        std::vector<expr_ptr> exprs_;
+    public:
+        fork_expr(const std::vector<expr_ptr>& exprs);
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
+        expr_ptr simplify() const override;
+        std::string to_string() const override;
+        void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
+    };
+
     class map_expr : public expression
     {
     private:
@@ -51,7 +66,7 @@ namespace tess {
     public:
         map_expr(expr_ptr lambda, expr_ptr cluster);
         std::string to_string() const override;
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         expr_ptr simplify() const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
     };
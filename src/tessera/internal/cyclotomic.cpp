@@ -0,0 +1,371 @@
+#include "cyclotomic.h"
+#include "boost/functional/hash.hpp"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <cmath>
+
+namespace {
+
+	constexpr int k_max_order = 240;
+	constexpr int k_max_denominator = 60;
+	constexpr int64_t k_max_coefficient = int64_t(1) << 30;
+	constexpr int64_t k_max_sum = int64_t(1) << 61;
+
+	int64_t checked_sum(int64_t a, int64_t b) {
+		auto sum = a + b;
+		if (sum > k_max_sum || sum < -k_max_sum)
+			throw tess::cyclotomic_overflow();
+		return sum;
+	}
+
+	// coefficients of x^n - 1 divided by the cyclotomic polynomials of the proper divisors of n.
+	std::vector<int64_t> cyclotomic_polynomial(int n, const std::map<int, std::vector<int64_t>>& lower) {
+		std::vector<int64_t> poly(n + 1, 0);
+		poly[0] = -1;
+		poly[n] = 1;
+		for (int d = 1; d < n; ++d) {
+			if (n % d != 0)
+				continue;
+			const auto& divisor = lower.at(d);
+			int deg = static_cast<int>(divisor.size()) - 1;
+			std::vector<int64_t> quotient(poly.size() - deg, 0);
+			for (int i = static_cast<int>(poly.size()) - 1; i >= deg; --i) {
+				auto c = poly[i];
+				quotient[i - deg] = c;
+				for (int j = 0; j <= deg; ++j)
+					poly[i - deg + j] -= c * divisor[j];
+			}
+			poly = std::move(quotient);
+		}
+		return poly;
+	}
+
+}
+
+struct tess::detail::cyclotomic_field {
+	int order;
+	int degree;
+	std::vector<int64_t> modulus;
+	std::vector<tess::point> basis;
+};
+
+namespace {
+
+	const tess::detail::cyclotomic_field* get_field(int n) {
+		static std::mutex mutex;
+		static std::map<int, std::unique_ptr<tess::detail::cyclotomic_field>> fields;
+		static std::map<int, std::vector<int64_t>> polynomials;
+
+		if (n < 1 || n > k_max_order)
+			throw tess::cyclotomic_overflow();
+
+		std::lock_guard<std::mutex> lock(mutex);
+		auto iter = fields.find(n);
+		if (iter != fields.end())
+			return iter->second.get();
+
+		for (int d = 1; d <= n; ++d)
+			if (n % d == 0 && polynomials.find(d) == polynomials.end())
+				polynomials[d] = cyclotomic_polynomial(d, polynomials);
+
+		auto field = std::make_unique<tess::detail::cyclotomic_field>();
+		field->order = n;
+		field->modulus = polynomials[n];
+		field->degree = static_cast<int>(field->modulus.size()) - 1;
+
+		// reduction below assumes the modulus coefficients are all -1, 0 or 1,
+		// which holds for every order not divisible by 105.
+		for (auto c : field->modulus)
+			if (c < -1 || c > 1)
+				throw tess::cyclotomic_overflow();
+
+		auto angle = (tess::number(2) * tess::pi()) / tess::number(n);
+		for (int k = 0; k < field->degree; ++k)
+			field->basis.push_back({ tess::cos(k * angle), tess::sin(k * angle) });
+
+		auto* ptr = field.get();
+		fields[n] = std::move(field);
+		return ptr;
+	}
+
+	std::vector<int64_t> reduce(std::vector<int64_t>&& poly, const tess::detail::cyclotomic_field& field) {
+		int deg = field.degree;
+		for (int i = static_cast<int>(poly.size()) - 1; i >= deg; --i) {
+			auto c = poly[i];
+			if (c == 0)
+				continue;
+			for (int j = 0; j < deg; ++j) {
+				if (field.modulus[j] != 0)
+					poly[i - deg + j] = checked_sum(poly[i - deg + j], -field.modulus[j] * c);
+			}
+			poly[i] = 0;
+		}
+		poly.resize(deg, 0);
+		for (auto c : poly)
+			if (c > k_max_coefficient || c < -k_max_coefficient)
+				throw tess::cyclotomic_overflow();
+		return std::move(poly);
+	}
+
+}
+
+tess::cyclotomic::cyclotomic() : cyclotomic(0)
+{
+}
+
+tess::cyclotomic::cyclotomic(int64_t integer) :
+	field_(get_field(1)),
+	coeffs_{ integer }
+{
+}
+
+tess::cyclotomic::cyclotomic(const detail::cyclotomic_field* field, std::vector<int64_t>&& coeffs) :
+	field_(field),
+	coeffs_(std::move(coeffs))
+{
+}
+
+tess::cyclotomic tess::cyclotomic::root_of_unity(int n, int k)
+{
+	auto field = get_field(n);
+	k = ((k % n) + n) % n;
+	std::vector<int64_t> poly(k + 1, 0);
+	poly[k] = 1;
+	return cyclotomic(field, reduce(std::move(poly), *field));
+}
+
+tess::cyclotomic tess::cyclotomic::from_coefficients(int n, std::vector<int64_t> coeffs)
+{
+	auto field = get_field(n);
+	return cyclotomic(field, reduce(std::move(coeffs), *field));
+}
+
+int tess::cyclotomic::order() const
+{
+	return field_->order;
+}
+
+const std::vector<int64_t>& tess::cyclotomic::coefficients() const
+{
+	return coeffs_;
+}
+
+tess::cyclotomic tess::cyclotomic::lift(int n) const
+{
+	if (n == order())
+		return *this;
+	if (n % order() != 0)
+		throw tess::cyclotomic_overflow();
+
+	auto field = get_field(n);
+	int step = n / order();
+	std::vector<int64_t> poly(step * (coeffs_.size() - 1) + 1, 0);
+	for (int k = 0; k < coeffs_.size(); ++k)
+		poly[k * step] = coeffs_[k];
+	return cyclotomic(field, reduce(std::move(poly), *field));
+}
+
+tess::cyclotomic tess::cyclotomic::conj() const
+{
+	int n = order();
+	std::vector<int64_t> poly(n, 0);
+	for (int k = 0; k < coeffs_.size(); ++k)
+		poly[(n - k) % n] = coeffs_[k];
+	return cyclotomic(field_, reduce(std::move(poly), *field_));
+}
+
+tess::point tess::cyclotomic::to_point() const
+{
+	number x = 0;
+	number y = 0;
+	for (int k = 0; k < coeffs_.size(); ++k) {
+		if (coeffs_[k] == 0)
+			continue;
+		auto [b_x, b_y] = field_->basis[k];
+		x += number(coeffs_[k]) * b_x;
+		y += number(coeffs_[k]) * b_y;
+	}
+	return { x, y };
+}
+
+std::size_t tess::cyclotomic::hash() const
+{
+	std::size_t seed = 0;
+	boost::hash_combine(seed, order());
+	boost::hash_range(seed, coeffs_.begin(), coeffs_.end());
+	return seed;
+}
+
+tess::cyclotomic tess::cyclotomic::operator+(const cyclotomic& rhs) const
+{
+	if (order() != rhs.order()) {
+		auto n = common_order(order(), rhs.order());
+		return lift(n) + rhs.lift(n);
+	}
+	std::vector<int64_t> sum(coeffs_.size());
+	for (int k = 0; k < coeffs_.size(); ++k)
+		sum[k] = coeffs_[k] + rhs.coeffs_[k];
+	return cyclotomic(field_, reduce(std::move(sum), *field_));
+}
+
+tess::cyclotomic tess::cyclotomic::operator-(const cyclotomic& rhs) const
+{
+	if (order() != rhs.order()) {
+		auto n = common_order(order(), rhs.order());
+		return lift(n) - rhs.lift(n);
+	}
+	std::vector<int64_t> diff(coeffs_.size());
+	for (int k = 0; k < coeffs_.size(); ++k)
+		diff[k] = coeffs_[k] - rhs.coeffs_[k];
+	return cyclotomic(field_, reduce(std::move(diff), *field_));
+}
+
+tess::cyclotomic tess::cyclotomic::operator*(const cyclotomic& rhs) const
+{
+	if (order() != rhs.order()) {
+		auto n = common_order(order(), rhs.order());
+		return lift(n) * rhs.lift(n);
+	}
+	std::vector<int64_t> product(2 * coeffs_.size() - 1, 0);
+	for (int i = 0; i < coeffs_.size(); ++i) {
+		if (coeffs_[i] == 0)
+			continue;
+		for (int j = 0; j < rhs.coeffs_.size(); ++j)
+			product[i + j] = checked_sum(product[i + j], coeffs_[i] * rhs.coeffs_[j]);
+	}
+	return cyclotomic(field_, reduce(std::move(product), *field_));
+}
+
+bool tess::cyclotomic::operator==(const cyclotomic& rhs) const
+{
+	if (order() != rhs.order()) {
+		auto n = common_order(order(), rhs.order());
+		return lift(n) == rhs.lift(n);
+	}
+	return coeffs_ == rhs.coeffs_;
+}
+
+bool tess::cyclotomic::operator!=(const cyclotomic& rhs) const
+{
+	return !(*this == rhs);
+}
+
+std::size_t tess::cyclotomic_hash::operator()(const cyclotomic& c) const
+{
+	return c.hash();
+}
+
+int tess::common_order(int n1, int n2)
+{
+	auto n = std::lcm(n1, n2);
+	if (n > k_max_order)
+		throw tess::cyclotomic_overflow();
+	return n;
+}
+
+/*--------------------------------------------------------------------------------*/
+
+tess::exact_transform::exact_transform() :
+	exact_transform(cyclotomic(1), cyclotomic(0), false)
+{
+}
+
+tess::exact_transform::exact_transform(const cyclotomic& rotation, const cyclotomic& translation, bool reflect) :
+	rotation_(rotation),
+	translation_(translation),
+	reflect_(reflect)
+{
+}
+
+tess::exact_transform tess::exact_transform::flip()
+{
+	return exact_transform(cyclotomic(1), cyclotomic(0), true);
+}
+
+std::optional<tess::exact_transform> tess::exact_transform::line_seg_to_line_seg(
+		const cyclotomic& src_u, const cyclotomic& src_v,
+		const cyclotomic& dest_u, const cyclotomic& dest_v)
+{
+	try {
+		auto src = src_v - src_u;
+		auto dest = dest_v - dest_u;
+
+		// only isometries keep us in the ring, so the rotation taking src to dest
+		// has to be a root of unity; find it from the floating point angle between
+		// the two and then verify it exactly.
+		auto [s_x, s_y] = src.to_point();
+		auto [d_x, d_y] = dest.to_point();
+		auto src_len = std::hypot(static_cast<double>(s_x), static_cast<double>(s_y));
+		auto dest_len = std::hypot(static_cast<double>(d_x), static_cast<double>(d_y));
+		if (std::abs(src_len - dest_len) > tess::eps * std::max(src_len, 1.0))
+			return std::nullopt;
+
+		int n = common_order(common_order(src.order(), dest.order()), 2);
+		auto theta = std::atan2(static_cast<double>(d_y), static_cast<double>(d_x)) -
+			std::atan2(static_cast<double>(s_y), static_cast<double>(s_x));
+		int k = static_cast<int>(std::lround(theta * n / (2.0 * 3.14159265358979323846)));
+		auto rotation = cyclotomic::root_of_unity(n, k);
+
+		if (rotation * src != dest)
+			return std::nullopt;
+
+		return exact_transform(rotation, dest_u - rotation * src_u, false);
+	} catch (const cyclotomic_overflow&) {
+		return std::nullopt;
+	}
+}
+
+tess::cyclotomic tess::exact_transform::apply(const cyclotomic& z) const
+{
+	return rotation_ * ((reflect_) ? z.conj() : z) + translation_;
+}
+
+tess::exact_transform tess::exact_transform::operator*(const exact_transform& rhs) const
+{
+	// this(rhs(z)) = r * s(r' * s'(z) + t') + t, where s is conjugation when reflecting
+	auto reflect = [this](const cyclotomic& z) { return (reflect_) ? z.conj() : z; };
+	return exact_transform(
+		rotation_ * reflect(rhs.rotation_),
+		rotation_ * reflect(rhs.translation_) + translation_,
+		reflect_ != rhs.reflect_
+	);
+}
+
+tess::exact_transform tess::exact_transform::inverse() const
+{
+	// the rotation is a root of unity so its inverse is its conjugate.
+	if (reflect_)
+		return exact_transform(rotation_, cyclotomic(0) - rotation_ * translation_.conj(), true);
+	auto inv_rotation = rotation_.conj();
+	return exact_transform(inv_rotation, cyclotomic(0) - inv_rotation * translation_, false);
+}
+
+int tess::exact_transform::order() const
+{
+	return common_order(rotation_.order(), translation_.order());
+}
+
+/*--------------------------------------------------------------------------------*/
+
+std::optional<std::tuple<int, int>> tess::as_rational_multiple_of_pi(number theta)
+{
+	auto ratio = static_cast<double>(theta / tess::pi());
+	for (int q = 1; q <= k_max_denominator; ++q) {
+		auto p = std::round(ratio * q);
+		if (std::abs(ratio * q - p) < 1e-9)
+			return std::tuple<int, int>{ static_cast<int>(p), q };
+	}
+	return std::nullopt;
+}
+
+std::optional<int64_t> tess::as_integer(number val)
+{
+	auto v = static_cast<double>(val);
+	auto i = std::round(v);
+	if (std::abs(v - i) > 1e-9 || std::abs(i) > static_cast<double>(k_max_coefficient))
+		return std::nullopt;
+	return static_cast<int64_t>(i);
+}
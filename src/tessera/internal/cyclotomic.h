@@ -0,0 +1,95 @@
+#pragma once
+
+#include "number.h"
+#include <vector>
+#include <optional>
+#include <stdexcept>
+#include <cstdint>
+
+namespace tess {
+
+	// whether built-in tiles with pi/n angles get exact vertex locations, see the 
+	// TESSERA_EXACT_COORDINATES option in CMakeLists.txt.
+#ifdef TESSERA_EXACT_COORDINATES
+	constexpr bool k_exact_coordinates = true;
+#else
+	constexpr bool k_exact_coordinates = false;
+#endif
+
+	namespace detail {
+		struct cyclotomic_field;
+	}
+
+	// thrown when an exact computation would need a field of too high an order or
+	// coefficients too large to hold; callers fall back to floating point.
+	class cyclotomic_overflow : public std::runtime_error {
+	public:
+		cyclotomic_overflow() : std::runtime_error("cyclotomic overflow") {}
+	};
+
+	// An element of Z[zeta_n], zeta_n = e^(2 pi i / n), treated as a point in the plane.
+	// Stored as integer coefficients in the power basis reduced modulo the nth
+	// cyclotomic polynomial, so equal values of the same order have equal representations.
+	class cyclotomic {
+	public:
+		cyclotomic();
+		cyclotomic(int64_t integer);
+		static cyclotomic root_of_unity(int n, int k);
+		// the element of Z[zeta_n] with the given power basis coefficients.
+		static cyclotomic from_coefficients(int n, std::vector<int64_t> coeffs);
+
+		int order() const;
+		const std::vector<int64_t>& coefficients() const;
+		cyclotomic lift(int n) const;
+		cyclotomic conj() const;
+		point to_point() const;
+		std::size_t hash() const;
+
+		cyclotomic operator+(const cyclotomic& rhs) const;
+		cyclotomic operator-(const cyclotomic& rhs) const;
+		cyclotomic operator*(const cyclotomic& rhs) const;
+		bool operator==(const cyclotomic& rhs) const;
+		bool operator!=(const cyclotomic& rhs) const;
+
+	private:
+		cyclotomic(const detail::cyclotomic_field* field, std::vector<int64_t>&& coeffs);
+
+		const detail::cyclotomic_field* field_;
+		std::vector<int64_t> coeffs_;
+	};
+
+	struct cyclotomic_hash {
+		std::size_t operator()(const cyclotomic& c) const;
+	};
+
+	int common_order(int n1, int n2);
+
+	// z -> rotation * z + translation, or rotation * conj(z) + translation if reflecting,
+	// where rotation is a root of unity; i.e. an isometry that maps Z[zeta_n] to itself.
+	class exact_transform {
+	public:
+		exact_transform();
+		static exact_transform flip();
+		static std::optional<exact_transform> line_seg_to_line_seg(
+			const cyclotomic& src_u, const cyclotomic& src_v,
+			const cyclotomic& dest_u, const cyclotomic& dest_v
+		);
+
+		cyclotomic apply(const cyclotomic& z) const;
+		exact_transform operator*(const exact_transform& rhs) const;
+		exact_transform inverse() const;
+		int order() const;
+
+	private:
+		exact_transform(const cyclotomic& rotation, const cyclotomic& translation, bool reflect);
+
+		cyclotomic rotation_;
+		cyclotomic translation_;
+		bool reflect_;
+	};
+
+	// attempts to express an angle as a rational multiple p/q of pi
+	// with a small denominator.
+	std::optional<std::tuple<int, int>> as_rational_multiple_of_pi(number theta);
+	std::optional<int64_t> as_integer(number val);
+}
@@ -8,101 +8,37 @@
 #include <string>
 #include <vector>
 
-namespace {
-
-    std::string placeholder(int i) {
-        return std::string("$") + std::to_string(i);
-    }
-
-}
-
-tess::scope_frame::scope_frame(const std::vector<std::string>& params, const std::vector<value_>& args)
-{
-    if (params.size() != args.size())
-        throw tess::error("params/args count mismatch.");
-    int n = static_cast<int>(args.size());
-    for (int i = 0; i < n; ++i)
-        definitions_[params[i]] = args[i];
-}
-
-tess::scope_frame::scope_frame(const std::vector<std::tuple<std::string, value_>>& assignments)
-{
-    std::transform(assignments.begin(), assignments.end(), std::inserter(definitions_, definitions_.end()),
-        [](const auto& assgn)->std::pair<std::string, value_> {
-            auto [var, val] = assgn;
-            return { var,val };
-        }
-    );
-}
-
-tess::scope_frame::scope_frame(const std::vector<value_>& args)
-{
-    int n = static_cast<int>(args.size());
-    for (int i = 0; i < n; i++)
-        definitions_[placeholder(i + 1)] = args[i];
-}
-
-std::optional<tess::value_> tess::scope_frame::get(int ph) const
-{
-    auto i = definitions_.find(placeholder(ph));
-    if (i != definitions_.end())
-        return i->second;
-    else
-        return std::nullopt;
-}
-
-std::optional<tess::value_> tess::scope_frame::get(std::string var) const
+tess::scope_frame::scope_frame(int num_slots) :
+    slots_(num_slots)
 {
-    auto i = definitions_.find(var);
-    if (i != definitions_.end())
-        return i->second;
-    else
-        return std::nullopt;
 }
 
-bool tess::scope_frame::has(std::string str) const
+const tess::value_* tess::scope_frame::get(int slot) const
 {
-    return definitions_.find(str) != definitions_.end();
+    if (slot >= static_cast<int>(slots_.size()) || !slots_[slot].has_value())
+        return nullptr;
+    return &(*slots_[slot]);
 }
 
 std::vector<tess::value_> tess::scope_frame::values() const
 {
-    std::vector<tess::value_> values(definitions_.size());
-    std::transform(definitions_.begin(), definitions_.end(), values.begin(),
-        [](const auto& def)->value_ {
-            return def.second;
-        }
-    );
+    std::vector<tess::value_> values;
+    for (const auto& slot : slots_)
+        if (slot.has_value())
+            values.push_back(*slot);
     return values;
 }
 
-void tess::scope_frame::set(const std::string& var, value_ val)
+void tess::scope_frame::set(int slot, value_ val)
 {
-    definitions_[var] = val;
+    if (slot >= static_cast<int>(slots_.size()))
+        slots_.resize(slot + 1);
+    slots_[slot] = std::move(val);
 }
 
-void tess::scope_frame::set(int i, value_ val)
+int tess::scope_frame::size() const
 {
-    definitions_[placeholder(i)] = val;
-}
-
-void tess::scope_frame::set(const::std::vector<std::string>& vars, const::std::vector<value_>& vals)
-{
-    if (vars.size() != vals.size())
-        throw tess::error("scope::frame::set: vars/vals count mismatch.");
-    int n = static_cast<int>(vars.size());
-    for (int i = 0; i < n; ++i)
-        definitions_[vars[i]] = vals[i];
-}
-
-tess::scope_frame::iterator tess::scope_frame::begin() const
-{
-    return definitions_.begin();
-}
-
-tess::scope_frame::iterator tess::scope_frame::end() const
-{
-    return definitions_.end();
+    return static_cast<int>(slots_.size());
 }
 
 std::string tess::scope_frame::to_string() const
@@ -110,72 +46,13 @@ std::string tess::scope_frame::to_string() const
     return "# scope frame #";
 }
 
-std::string tess::scope_frame::serialize(serialization_state& state) const {
-    std::stringstream ss;
-    ss << "{";
-    for (const auto& [key, val] : definitions_) {
-        auto val_str = tess::serialize(state, val);
-        if (val_str.empty())
-            return {};
-        ss << "(" << key << "," << val_str << ")";
-    }
-    ss << "}";
-    return ss.str();
-}
-
-tess::scope_frame::scope_frame(const std::string& var, value_ val)
-{
-    definitions_[var] = val;
-}
-/*
-void tess::scope_frame::get_references(std::unordered_set<tess::obj_id> &objects) const {
-    for (const auto& [key, val] : definitions_) {
-        tess::get_references(val, objects);
-    }
-}
-*/
-
 /*------------------------------------------------------------------------------------------------------*/
 
-std::optional<tess::value_> tess::evaluation_context::get_maybe(const std::string& var) const
+const tess::value_* tess::evaluation_context::get(int depth, int slot) const
 {
-    for (auto i = scopes_.rbegin(); i != scopes_.rend(); ++i) {
-        auto maybe_value = i->get(var);
-        if (maybe_value.has_value())
-            return maybe_value.value();
-    }
-    return std::nullopt;
-}
-
-bool tess::evaluation_context::contains(const std::string& var) const
-{
-    return get_maybe(var).has_value();
-}
-
-bool tess::evaluation_context::contains(int i) const
-{
-    return contains(placeholder(i));
-}
-
-bool tess::evaluation_context::has(const std::string& var) const
-{
-    auto maybe_value = get_maybe(var);
-    return maybe_value.has_value();
-}
-
-tess::value_ tess::evaluation_context::get(const std::string& var) const
-{
-    auto maybe_value = get_maybe(var);
-
-    if (!maybe_value.has_value())
-        throw tess::error("Unknown variable: " + var);
-
-    return maybe_value.value();
-}
-
-tess::value_ tess::evaluation_context::get(int i) const
-{
-    return get(placeholder(i));
+    if (depth >= static_cast<int>(scopes_.size()))
+        return nullptr;
+    return scopes_[scopes_.size() - 1 - depth].get(slot);
 }
 
 tess::scope_frame& tess::evaluation_context::peek()
@@ -198,11 +75,9 @@ void tess::evaluation_context::push_scope(const scope_frame& scope)
     scopes_.push_back(scope);
 }
 
-tess::scope_frame tess::evaluation_context::pop_scope()
+void tess::evaluation_context::pop_scope()
 {
-    auto frame = scopes_.back();
     scopes_.pop_back();
-    return frame;
 }
 
 tess::gc_heap& tess::evaluation_context::allocator()
@@ -225,14 +100,6 @@ int tess::evaluation_context::num_frames() const
     return static_cast<int>(scopes_.size());
 }
 
-/*
-void tess::evaluation_context::get_references(std::unordered_set<tess::obj_id> &objects) const {
-    for (const auto& scope : scopes_) {
-        scope.get_references(objects);
-    }
-}
-*/
-
 const tess::evaluation_context& tess::context_stack::top() const {
     return impl_.back();
 }
@@ -258,27 +125,3 @@ tess::memoization_tbl& tess::context_stack::memos()
 {
     return memos_;
 }
-
-void tess::memoization_tbl::insert(const std::string& key, tess::value_ v)
-{
-    tbl_[key] = v;
-}
-
-bool tess::memoization_tbl::contains(const std::string& key) const
-{
-    return tbl_.find(key) != tbl_.end();
-}
-
-tess::value_ tess::memoization_tbl::get(const std::string& key) const
-{
-    auto iter = tbl_.find(key);
-    if (iter != tbl_.end())
-        return iter->second;
-    else
-        return { tess::nil_val() };
-}
-
-std::size_t tess::memoization_tbl::size() const
-{
-    return tbl_.size();
-}
@@ -1,4 +1,5 @@
 #include "number.h"
+#include "cyclotomic.h"
 #include "expression.h"
 #include "value.h"
 #include "lambda_impl.h"
@@ -87,6 +88,128 @@ namespace {
 		return { {0,0}, {c,0}, {C_x,C_y} };
 	}
 
+	// exact cyclotomic vertex locations for the built-in tiles whose angles are rational multiples of pi.
+
+	using exact_locations = std::optional<std::vector<tess::cyclotomic>>;
+
+	exact_locations exact_regular_polygon_vertices(tess::number num_sides)
+	{
+		if (!tess::k_exact_coordinates)
+			return std::nullopt;
+		int n = tess::to_int(num_sides);
+		std::vector<tess::cyclotomic> points;
+		for (int i = 0; i < n; i++)
+			points.push_back(tess::cyclotomic::root_of_unity(n, i));
+		return points;
+	}
+
+	exact_locations exact_isosceles_triangle(tess::number theta)
+	{
+		auto ratio = tess::as_rational_multiple_of_pi(theta);
+		if (!tess::k_exact_coordinates || !ratio)
+			return std::nullopt;
+		auto [p, q] = *ratio;
+		if (p <= 0 || p >= q)
+			return std::nullopt;
+
+		// the apex is at angle pi/2 - theta/2 on the unit circle
+		auto apex = tess::cyclotomic::root_of_unity(4 * q, q - p);
+		return std::vector<tess::cyclotomic>{ 0, apex + apex.conj(), apex };
+	}
+
+	exact_locations exact_quadrilateral(tess::number d, tess::number theta)
+	{
+		auto ratio = tess::as_rational_multiple_of_pi(theta);
+		auto len = tess::as_integer(d);
+		if (!tess::k_exact_coordinates || !ratio || !len)
+			return std::nullopt;
+		auto [p, q] = *ratio;
+		auto side1 = tess::cyclotomic(*len) * tess::cyclotomic::root_of_unity(2 * q, p);
+		auto side2 = tess::cyclotomic(*len) * tess::cyclotomic::root_of_unity(2 * q, q - p);
+		return std::vector<tess::cyclotomic>{ 0, 1, side2 + 1, side1 };
+	}
+
+	exact_locations exact_isosceles_trapezoid(tess::number theta, tess::number len)
+	{
+		return exact_quadrilateral(len, theta);
+	}
+
+	exact_locations exact_rhombus(tess::number theta)
+	{
+		auto ratio = tess::as_rational_multiple_of_pi(theta);
+		if (!tess::k_exact_coordinates || !ratio)
+			return std::nullopt;
+		auto [p, q] = *ratio;
+		auto side = tess::cyclotomic::root_of_unity(2 * q, p);
+		return std::vector<tess::cyclotomic>{ 0, 1, side + 1, side };
+	}
+
+	exact_locations exact_polygon(const std::vector<std::tuple<tess::number, tess::number>>& locs)
+	{
+		if (!tess::k_exact_coordinates)
+			return std::nullopt;
+		auto i = tess::cyclotomic::root_of_unity(4, 1);
+		std::vector<tess::cyclotomic> points;
+		for (auto [x, y] : locs) {
+			auto int_x = tess::as_integer(x);
+			auto int_y = tess::as_integer(y);
+			if (!int_x || !int_y)
+				return std::nullopt;
+			points.push_back(tess::cyclotomic(*int_x) + tess::cyclotomic(*int_y) * i);
+		}
+		return points;
+	}
+
+	struct tile_vertices {
+		exact_locations exact;
+		std::vector<std::tuple<tess::number, tess::number>> locs;
+	};
+
+	template<typename F>
+	tile_vertices get_tile_vertices(F exact_locations, const std::vector<std::tuple<tess::number, tess::number>>& locs)
+	{
+		try {
+			return { exact_locations(), locs };
+		} catch (const tess::cyclotomic_overflow&) {
+		}
+		return { std::nullopt, locs };
+	}
+
+	tile_vertices regular_polygon_tile(tess::number num_sides)
+	{
+		return get_tile_vertices([&]() { return exact_regular_polygon_vertices(num_sides); }, regular_polygon_vertices(num_sides));
+	}
+
+	tile_vertices isosceles_triangle_tile(tess::number theta)
+	{
+		return get_tile_vertices([&]() { return exact_isosceles_triangle(theta); }, isosceles_triangle(theta));
+	}
+
+	tile_vertices isosceles_trapezoid_tile(tess::number theta, tess::number len)
+	{
+		return get_tile_vertices([&]() { return exact_isosceles_trapezoid(theta, len); }, isosceles_trapezoid(theta, len));
+	}
+
+	tile_vertices rhombus_tile(tess::number theta)
+	{
+		return get_tile_vertices([&]() { return exact_rhombus(theta); }, rhombus(theta));
+	}
+
+	tess::value_ make_tile(tess::gc_heap& a, const tile_vertices& vertices)
+	{
+		if (vertices.exact.has_value())
+			return tess::value_(a.make_const<tess::const_tile_root_ptr>(*vertices.exact));
+		return tess::value_(a.make_const<tess::const_tile_root_ptr>(vertices.locs));
+	}
+
+	// a native that builds a tile from vertices simplify() has already computed.
+	tess::stack_machine::native_func precomputed_tile(tile_vertices vertices)
+	{
+		return [vertices](tess::gc_heap& a, tess::stack_machine::args_view args)->tess::value_ {
+			return make_tile(a, vertices);
+		};
+	}
+
 	tess::value_ flip(tess::gc_heap& a, const tess::value_& arg)
 	{
 		if (!std::holds_alternative<tess::const_tile_root_ptr>(arg) && !std::holds_alternative<tess::const_patch_root_ptr>(arg))
@@ -123,103 +246,157 @@ namespace {
 		return tuples;
 	}
 
+	// what simplify() can do ahead of time with a call whose arguments are all constant
+	// numbers: either work out its value or leave a native that only has to build it.
+	using folded_call = std::variant<tess::number, tess::stack_machine::native_func>;
+	using fold_func = std::function<folded_call(const std::vector<tess::number>&)>;
+
+	fold_func fold_number(tess::number (*func)(tess::number))
+	{
+		return [func](const std::vector<tess::number>& args)->folded_call {
+			return func(args[0]);
+		};
+	}
+
 	struct special_func_def {
 		tess::parser::kw tok;
 		int num_parameters;
-		std::function<tess::value_(tess::gc_heap&, const std::vector<tess::value_>&)> func;
+		tess::stack_machine::native_func func;
+		fold_func fold;
 	};
 
 	std::vector<special_func_def> g_special_function_definitions = {
 		{
 			tess::parser::kw::arccos, 1,
-			[](tess::gc_heap& a, const std::vector<tess::value_>& args)->tess::value_ { return tess::value_( tess::acos(std::get<tess::number>(args[0])) ); }
+			[](tess::gc_heap& a, tess::stack_machine::args_view args)->tess::value_ { return tess::value_( tess::acos(std::get<tess::number>(args[0])) ); },
+			fold_number(tess::acos)
 		} , {
 			tess::parser::kw::arcsin, 1,
-			[](tess::gc_heap& a,  const std::vector<tess::value_>& args)->tess::value_ { return tess::value_(tess::asin(std::get<tess::number>(args[0])) ); }
+			[](tess::gc_heap& a, tess::stack_machine::args_view args)->tess::value_ { return tess::value_(tess::asin(std::get<tess::number>(args[0])) ); },
+			fold_number(tess::asin)
 		} , {
 			tess::parser::kw::arctan, 1,
-			[](tess::gc_heap& a, const std::vector<tess::value_>& args)->tess::value_ { return tess::value_(tess::atan(std::get<tess::number>(args[0])) ); }
+			[](tess::gc_heap& a, tess::stack_machine::args_view args)->tess::value_ { return tess::value_(tess::atan(std::get<tess::number>(args[0])) ); },
+			fold_number(tess::atan)
 		} , {
 			tess::parser::kw::cos, 1,
-			[](tess::gc_heap& a, const std::vector<tess::value_>& args)->tess::value_ { return tess::value_(tess::cos(std::get<tess::number>(args[0])) ); }
+			[](tess::gc_heap& a, tess::stack_machine::args_view args)->tess::value_ { return tess::value_(tess::cos(std::get<tess::number>(args[0])) ); },
+			fold_number(tess::cos)
 		} , {
 			tess::parser::kw::sin, 1,
-			[](tess::gc_heap& a, const std::vector<tess::value_>& args)->tess::value_ { return tess::value_(tess::sin(std::get<tess::number>(args[0])) ); }
+			[](tess::gc_heap& a, tess::stack_machine::args_view args)->tess::value_ { return tess::value_(tess::sin(std::get<tess::number>(args[0])) ); },
+			fold_number(tess::sin)
 		} , {
 			tess::parser::kw::sqrt, 1,
-			[](tess::gc_heap& a, const std::vector<tess::value_>& args)->tess::value_ { return tess::value_(tess::sqrt(std::get<tess::number>(args[0])) ); }
+			[](tess::gc_heap& a, tess::stack_machine::args_view args)->tess::value_ { return tess::value_(tess::sqrt(std::get<tess::number>(args[0])) ); },
+			fold_number(tess::sqrt)
 		} , {
 			tess::parser::kw::tan, 1,
-			[](tess::gc_heap& a, const std::vector<tess::value_>& args)->tess::value_ { return tess::value_(tess::tan(std::get<tess::number>(args[0])) ); }
+			[](tess::gc_heap& a, tess::stack_machine::args_view args)->tess::value_ { return tess::value_(tess::tan(std::get<tess::number>(args[0])) ); },
+			fold_number(tess::tan)
 		} , {
 			tess::parser::kw::regular_polygon, 1,
-			[](tess::gc_heap& a, const std::vector<tess::value_>& args)->tess::value_ {
-				auto locs = regular_polygon_vertices(std::get<tess::number>(args[0]));
-				return tess::value_( a.make_const<tess::const_tile_root_ptr>( locs) );
+			[](tess::gc_heap& a, tess::stack_machine::args_view args)->tess::value_ {
+				return make_tile(a, regular_polygon_tile(std::get<tess::number>(args[0])));
+			},
+			[](const std::vector<tess::number>& args)->folded_call {
+				return precomputed_tile(regular_polygon_tile(args[0]));
 			}
 		} , {
 			tess::parser::kw::flip, 1,
-			[](tess::gc_heap& a, const std::vector<tess::value_>& args)->tess::value_ {
+			[](tess::gc_heap& a, tess::stack_machine::args_view args)->tess::value_ {
 				return flip(a, args[0]);
 			}
 		} , {
 			tess::parser::kw::isosceles_triangle, 1,
-			[](tess::gc_heap& a, const std::vector<tess::value_>& args)->tess::value_ {
-				auto locs = isosceles_triangle(std::get<tess::number>(args[0]));
-				return tess::value_( a.make_const<tess::const_tile_root_ptr>(locs) );
+			[](tess::gc_heap& a, tess::stack_machine::args_view args)->tess::value_ {
+				return make_tile(a, isosceles_triangle_tile(std::get<tess::number>(args[0])));
+			},
+			[](const std::vector<tess::number>& args)->folded_call {
+				return precomputed_tile(isosceles_triangle_tile(args[0]));
 			}
 		} , {
 			tess::parser::kw::isosceles_trapezoid, 2,
-			[](tess::gc_heap& a, const std::vector<tess::value_>& args)->tess::value_ {
-				auto locs = isosceles_trapezoid(std::get<tess::number>(args[0]), std::get<tess::number>(args[1]));
-				return tess::value_( a.make_const<tess::const_tile_root_ptr>(locs));
+			[](tess::gc_heap& a, tess::stack_machine::args_view args)->tess::value_ {
+				return make_tile(a, isosceles_trapezoid_tile(std::get<tess::number>(args[0]), std::get<tess::number>(args[1])));
+			},
+			[](const std::vector<tess::number>& args)->folded_call {
+				return precomputed_tile(isosceles_trapezoid_tile(args[0], args[1]));
 			}
 		} , {
 			tess::parser::kw::rhombus, 1,
-			[](tess::gc_heap& a, const std::vector<tess::value_>& args)->tess::value_ {
-				auto locs = rhombus(std::get<tess::number>(args[0]));
-				return tess::value_( a.make_const<tess::const_tile_root_ptr>(locs) );
+			[](tess::gc_heap& a, tess::stack_machine::args_view args)->tess::value_ {
+				return make_tile(a, rhombus_tile(std::get<tess::number>(args[0])));
+			},
+			[](const std::vector<tess::number>& args)->folded_call {
+				return precomputed_tile(rhombus_tile(args[0]));
 			}
 		} , {
 			tess::parser::kw::polygon, 1,
-			[](tess::gc_heap& a, const std::vector<tess::value_>& args)->tess::value_ {
+			[](tess::gc_heap& a, tess::stack_machine::args_view args)->tess::value_ {
 				auto locs = polygon(args[0]);
-				return tess::value_( a.make_const<tess::const_tile_root_ptr>(locs) );
+				return make_tile(a, get_tile_vertices([&]() { return exact_polygon(locs); }, locs));
 			}
 		} , {
 			tess::parser::kw::join, 1,
-			[](tess::gc_heap& a,const std::vector<tess::value_>& args)->tess::value_ {
+			[](tess::gc_heap& a, tess::stack_machine::args_view args)->tess::value_ {
 				auto patch = std::get<tess::const_patch_root_ptr>(args[0]);
 				return tess::make_value(patch->join(a) );
 			}
 		} , {
 			tess::parser::kw::triangle_by_sides, 3,
-			[](tess::gc_heap& a, const std::vector<tess::value_>& args)->tess::value_ {
+			[](tess::gc_heap& a, tess::stack_machine::args_view args)->tess::value_ {
 				auto locs = triangle_by_sides(std::get<tess::number>(args[0]), std::get<tess::number>(args[1]), std::get<tess::number>(args[2]));
 				return tess::value_(a.make_const<tess::const_tile_root_ptr>(locs) );
+			},
+			[](const std::vector<tess::number>& args)->folded_call {
+				return precomputed_tile({ std::nullopt, triangle_by_sides(args[0], args[1], args[2]) });
 			}
 		} 
 	};
 
 	std::optional<special_func_def> get_special_func_def(tess::parser::kw tok) {
-		static std::unordered_map<tess::parser::kw, special_func_def> tbl;
-		if (tbl.empty()) {
+		// scripts can be parsed on several threads at once, so the table is built by a
+		// static initializer rather than on first use.
+		static const std::unordered_map<tess::parser::kw, special_func_def> tbl = []() {
+			std::unordered_map<tess::parser::kw, special_func_def> tbl;
 			std::transform(g_special_function_definitions.begin(), g_special_function_definitions.end(), std::inserter(tbl, tbl.end()),
 				[](const special_func_def& def)->std::unordered_map<tess::parser::kw, special_func_def>::value_type {
 					return { def.tok, def };
 				}
 			);
-		}
+			return tbl;
+		}();
 		auto iter = tbl.find(tok);
 		if (iter == tbl.end())
 			return std::nullopt;
 		return iter->second;
 	}
+
+	std::optional<tess::number> constant_number(const tess::expr_ptr& e)
+	{
+		auto num = std::dynamic_pointer_cast<tess::number_expr>(e);
+		if (!num)
+			return std::nullopt;
+		return num->value();
+	}
+
+	std::optional<std::vector<tess::number>> constant_numbers(const std::vector<tess::expr_ptr>& exprs)
+	{
+		std::vector<tess::number> numbers;
+		for (const auto& e : exprs) {
+			auto num = constant_number(e);
+			if (!num)
+				return std::nullopt;
+			numbers.push_back(*num);
+		}
+		return numbers;
+	}
 }
 
 /*----------------------------------------------------------------------*/
 
-tess::number_expr::number_expr(double v) : val_(v)
+tess::number_expr::number_expr(const number& v) : val_(v)
 {
 }
 
@@ -227,9 +404,9 @@ tess::number_expr::number_expr(int v) : val_(v)
 {
 }
 
-void tess::number_expr::compile(stack_machine::stack& stack) const
+void tess::number_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
-	stack.push(tess::value_{ tess::number(val_) });
+	stack.push(tess::value_{ val_ });
 }
 
 std::string tess::number_expr::to_string() const
@@ -261,11 +438,11 @@ tess::addition_expr::addition_expr(const std::vector<std::tuple<bool, expr_ptr>>
 {
 }
 
-void tess::addition_expr::compile(stack_machine::stack& stack) const
+void tess::addition_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
 	stack.push(std::make_shared<val_func_op>( 
 		static_cast<int>(terms_.size()),
-		[](gc_heap& a, const std::vector<value_>& args)->value_ {
+		[](gc_heap& a, stack_machine::args_view args)->value_ {
 			number sum = 0;
 			for (const auto& term : args) {
 				sum += std::get<number>(term);
@@ -280,14 +457,14 @@ void tess::addition_expr::compile(stack_machine::stack& stack) const
 			stack.push(
 				std::make_shared<val_func_op>(
 					1,
-					[](gc_heap& a, const std::vector<value_>& args)->value_ {
+					[](gc_heap& a, stack_machine::args_view args)->value_ {
 						return tess::value_(-std::get<number>(args[0]) );
 					},
 					"<neg>"
 				)
 			);
 		}
-		term_expr->compile(stack);
+		term_expr->compile(stack, scope);
 	}
 }
 
@@ -320,13 +497,26 @@ tess::expr_ptr tess::addition_expr::simplify() const
 	if (terms_.size() == 1 && std::get<0>(terms_[0])) {
 		return std::get<1>(terms_[0])->simplify();
 	}
-	std::vector<std::tuple<bool, expr_ptr>> simplified(terms_.size());
-	std::transform(terms_.begin(), terms_.end(), simplified.begin(),
-		[](const auto& term)->std::tuple<bool, expr_ptr> {
-			const auto& [sgn, e] = term;
-			return { sgn, e->simplify() };
+
+	// fold the constant terms at the front into one. The sum is taken in order 
+	// starting from 0 like <add> does, so the result is exactly what evaluating 
+	// them would give; constants after the first variable term are left alone.
+	std::vector<std::tuple<bool, expr_ptr>> simplified;
+	std::optional<number> sum;
+	for (const auto& [sgn, e] : terms_) {
+		auto term = e->simplify();
+		auto val = constant_number(term);
+		if (val && simplified.empty()) {
+			sum = sum.value_or(number(0)) + (sgn ? *val : -*val);
+			continue;
 		}
-	);
+		simplified.push_back({ sgn, term });
+	}
+	if (sum.has_value()) {
+		if (simplified.empty())
+			return std::make_shared<number_expr>(*sum);
+		simplified.insert(simplified.begin(), { true, std::make_shared<number_expr>(*sum) });
+	}
 	return std::make_shared<addition_expr>(simplified);
 }
 
@@ -343,11 +533,11 @@ tess::multiplication_expr::multiplication_expr(const std::vector<std::tuple<bool
 {
 }
 
-void tess::multiplication_expr::compile(stack_machine::stack& stack) const
+void tess::multiplication_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
 	stack.push(std::make_shared<val_func_op>(
 			static_cast<int>(factors_.size()),
-			[](gc_heap& a, const std::vector<value_>& args)->value_ {
+			[](gc_heap& a, stack_machine::args_view args)->value_ {
 				number product = 1;
 				for (const auto& term : args) {
 					product *= std::get<number>(term);
@@ -362,14 +552,14 @@ void tess::multiplication_expr::compile(stack_machine::stack& stack) const
 			stack.push(
 				std::make_shared<val_func_op>(
 					1,
-					[](gc_heap& a, const std::vector<value_>& args)->value_ {
+					[](gc_heap& a, stack_machine::args_view args)->value_ {
 						return tess::value_(number(1) / std::get<number>(args[0]) );
 					},
 					"<reciprocal>"
 				)
 			);
 		}
-		factor_expr->compile(stack);
+		factor_expr->compile(stack, scope);
 	}
 }
 
@@ -384,13 +574,24 @@ tess::expr_ptr tess::multiplication_expr::simplify() const
 	if (factors_.size() == 1 && std::get<0>(factors_[0])) {
 		return  std::get<1>(factors_[0])->simplify();
 	}
-	std::vector<std::tuple<bool, expr_ptr>> simplified(factors_.size());
-	std::transform(factors_.begin(), factors_.end(), simplified.begin(),
-		[](const auto& term)->std::tuple<bool, expr_ptr> {
-			const auto& [op, e] = term;
-			return { op, e->simplify() };
+
+	// as with addition, only the constant factors at the front are folded.
+	std::vector<std::tuple<bool, expr_ptr>> simplified;
+	std::optional<number> product;
+	for (const auto& [op, e] : factors_) {
+		auto factor = e->simplify();
+		auto val = constant_number(factor);
+		if (val && simplified.empty()) {
+			product = product.value_or(number(1)) * (op ? *val : number(1) / *val);
+			continue;
 		}
-	);
+		simplified.push_back({ op, factor });
+	}
+	if (product.has_value()) {
+		if (simplified.empty())
+			return std::make_shared<number_expr>(*product);
+		simplified.insert(simplified.begin(), { true, std::make_shared<number_expr>(*product) });
+	}
 	return std::make_shared< multiplication_expr>(simplified);
 }
 
@@ -426,12 +627,12 @@ tess::exponent_expr::exponent_expr(expr_ptr base, const std::vector<expr_ptr>& e
 {
 }
 
-void tess::exponent_expr::compile(stack_machine::stack& stack) const
+void tess::exponent_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
 	int n = static_cast<int>(exponents_.size() + 1);
 	stack.push(std::make_shared<val_func_op>(
 			n,
-			[](gc_heap& a, const std::vector<value_>& args)->value_ {
+			[](gc_heap& a, stack_machine::args_view args)->value_ {
 				number power = std::get<number>(args[0]);
 				if (args.size() > 1) {
 					for (auto e = std::next(args.begin()); e != args.end(); e++) 
@@ -442,9 +643,9 @@ void tess::exponent_expr::compile(stack_machine::stack& stack) const
 			"<exp " + std::to_string(n) + ">"
 		)
 	);
-	base_->compile(stack);
+	base_->compile(stack, scope);
 	for (auto exp : exponents_) {
-		exp->compile(stack);
+		exp->compile(stack, scope);
 	}
 }
 
@@ -459,13 +660,27 @@ tess::expr_ptr tess::exponent_expr::simplify() const
 {
 	if (exponents_.empty())
 		return base_->simplify();
-	std::vector<expr_ptr> simplified(exponents_.size());
-	std::transform(exponents_.begin(), exponents_.end(), simplified.begin(),
-		[](const auto& e) {
-			return e->simplify();
+
+	// powers are taken left to right, so a constant base folds with the constant
+	// exponents that directly follow it.
+	auto base = base_->simplify();
+	auto power = constant_number(base);
+	std::vector<expr_ptr> simplified;
+	for (const auto& e : exponents_) {
+		auto exponent = e->simplify();
+		auto val = constant_number(exponent);
+		if (power && val && simplified.empty()) {
+			power = tess::pow(*power, *val);
+			continue;
 		}
-	);
-	return std::make_shared< exponent_expr>(base_->simplify(), simplified);
+		simplified.push_back(exponent);
+	}
+	if (power.has_value()) {
+		base = std::make_shared<number_expr>(*power);
+		if (simplified.empty())
+			return base;
+	}
+	return std::make_shared< exponent_expr>(base, simplified);
 }
 /*----------------------------------------------------------------------*/
 
@@ -486,7 +701,7 @@ tess::special_number_expr::special_number_expr(special_num which) :
 {
 }
 
-void tess::special_number_expr::compile(stack_machine::stack& stack) const
+void tess::special_number_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
 	switch (num_) {
 		case special_num::pi:
@@ -506,7 +721,7 @@ void tess::special_number_expr::compile(stack_machine::stack& stack) const
 tess::string_expr::string_expr(std::string str) : val_(str)
 {}
 
-void tess::string_expr::compile(stack_machine::stack& stack) const
+void tess::string_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
 	stack.push(tess::value_{ val_ });
 }
@@ -526,6 +741,14 @@ void tess::string_expr::get_dependencies(std::unordered_set<std::string>& depend
 
 tess::expr_ptr tess::special_number_expr::simplify() const
 {
+	switch (num_) {
+		case special_num::pi:
+			return std::make_shared<number_expr>(tess::pi());
+		case special_num::phi:
+			return std::make_shared<number_expr>(tess::phi());
+		case special_num::root_2:
+			return std::make_shared<number_expr>(tess::root_2());
+	}
 	return std::make_shared<special_number_expr>(num_);
 }
 
@@ -547,13 +770,18 @@ tess::special_function_expr::special_function_expr(parser::kw func, expr_ptr arg
 {
 }
 
-tess::special_function_expr::special_function_expr(parser::kw func, const std::vector<expr_ptr>& args) :
-	func_(func), args_(args)
+tess::special_function_expr::special_function_expr(parser::kw func, const std::vector<expr_ptr>& args, stack_machine::native_func precomputed) :
+	func_(func), args_(args), precomputed_(precomputed)
 {
 }
 
-void tess::special_function_expr::compile(stack_machine::stack& stack) const
+void tess::special_function_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
+	if (precomputed_) {
+		stack.push(std::make_shared<val_func_op>(0, precomputed_, parser::keyword(func_)));
+		return;
+	}
+
 	auto maybe_func_definition = get_special_func_def(func_);
 	if (!maybe_func_definition.has_value())
 		throw tess::error("Unknown special function.");
@@ -568,7 +796,7 @@ void tess::special_function_expr::compile(stack_machine::stack& stack) const
 	);
 
 	for (auto arg : args_)
-		arg->compile(stack);
+		arg->compile(stack, scope);
 }
 
 void tess::special_function_expr::get_dependencies(std::unordered_set<std::string>& dependencies) const
@@ -579,12 +807,30 @@ void tess::special_function_expr::get_dependencies(std::unordered_set<std::strin
 
 tess::expr_ptr tess::special_function_expr::simplify() const
 {
+	if (precomputed_)
+		return std::make_shared< special_function_expr>(func_, args_, precomputed_);
+
 	std::vector<expr_ptr> simplified_args(args_.size());
 	std::transform(args_.begin(), args_.end(), simplified_args.begin(),
 		[](const expr_ptr& e)->expr_ptr {
 			return e->simplify();
 		}
 	);
+
+	// a call whose arguments are all constant is done once, here, rather than every
+	// time it is evaluated.
+	auto func_def = get_special_func_def(func_);
+	auto args = constant_numbers(simplified_args);
+	if (func_def && func_def->fold && args && static_cast<int>(args->size()) == func_def->num_parameters) {
+		try {
+			auto folded = func_def->fold(*args);
+			if (std::holds_alternative<number>(folded))
+				return std::make_shared<number_expr>(std::get<number>(folded));
+			return std::make_shared< special_function_expr>(func_, simplified_args, std::get<stack_machine::native_func>(folded));
+		} catch (...) {
+			// leave it to fail when it is evaluated, where the error is reported.
+		}
+	}
 	return std::make_shared< special_function_expr>(func_, simplified_args);
 }
 
@@ -605,13 +851,13 @@ tess::and_expr::and_expr(const std::vector<expr_ptr>& conjuncts) :
 {
 }
 
-void tess::and_expr::compile(stack_machine::stack& stack) const
+void tess::and_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
 	int n = static_cast<int>(conjuncts_.size());
 	stack.push(
 		std::make_shared<val_func_op>(
 			n,
-			[](gc_heap& a, const std::vector<value_>& args)->value_ {
+			[](gc_heap& a, stack_machine::args_view args)->value_ {
 				for (const auto& conjunct : args) {
 					auto val = std::get<bool>(conjunct);
 					if (!val)
@@ -623,7 +869,7 @@ void tess::and_expr::compile(stack_machine::stack& stack) const
 		)
 	);
 	for (const auto& conjuct : conjuncts_)
-		conjuct->compile(stack);
+		conjuct->compile(stack, scope);
 }
 
 void tess::and_expr::get_dependencies(std::unordered_set<std::string>& dependencies) const
@@ -650,24 +896,19 @@ tess::equality_expr::equality_expr(const std::vector<expr_ptr> operands) :
 {
 }
 
-void tess::equality_expr::compile(stack_machine::stack& stack) const
+void tess::equality_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
 	int n = static_cast<int>(operands_.size());
 	stack.push(
 		std::make_shared<val_func_op>(
 			n,
-			[](gc_heap& a, const std::vector<value_>& args) -> value_ {
-
-				std::vector<number> expressions;
-				expressions.reserve(args.size());
-				for (const auto& op : args) {
-					expressions.push_back(std::get<number>(op));
-				}
-
-				auto first = expressions.front();
-				for (int i = 1; i < expressions.size(); ++i)
-					if (!equals(first, expressions[i]))
+			[](gc_heap& a, stack_machine::args_view args) -> value_ {
+				auto first = std::get<number>(args[0]);
+				for (int i = 1; i < args.size(); ++i) {
+					auto val = std::get<number>(args[i]);
+					if (!equals(first, val))
 						return tess::value_(false );
+				}
 
 				return tess::value_(true );
 			},
@@ -675,7 +916,7 @@ void tess::equality_expr::compile(stack_machine::stack& stack) const
 		)
 	);
 	for (const auto& o : operands_)
-		o->compile(stack);
+		o->compile(stack, scope);
 }
 
 void tess::equality_expr::get_dependencies(std::unordered_set<std::string>& dependencies) const
@@ -702,12 +943,12 @@ tess::or_expr::or_expr(const std::vector<expr_ptr> disjuncts) :
 {
 }
 
-void tess::or_expr::compile(stack_machine::stack& stack) const
+void tess::or_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
 	stack.push(
 		std::make_shared<val_func_op>(
 			static_cast<int>(disjuncts_.size()),
-			[](gc_heap& a, const std::vector<value_>& args) -> value_ {
+			[](gc_heap& a, stack_machine::args_view args) -> value_ {
 				for (const auto& disjunct : args) {
 					auto val = std::get<bool>(disjunct);
 					if (val)
@@ -719,7 +960,7 @@ void tess::or_expr::compile(stack_machine::stack& stack) const
 		)
 	);
 	for (const auto& d : disjuncts_)
-		d->compile(stack);
+		d->compile(stack, scope);
 }
 
 void tess::or_expr::get_dependencies(std::unordered_set<std::string>& dependencies) const
@@ -766,13 +1007,13 @@ tess::relation_expr::relation_expr(expr_ptr lhs, relation_op op, expr_ptr rhs) :
 {
 }
 
-void tess::relation_expr::compile(stack_machine::stack& stack) const
+void tess::relation_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
 	auto relation = op_;
 	stack.push(
 		std::make_shared<val_func_op>(
 			2,
-			[relation](gc_heap& a, const std::vector<value_>& args) -> value_ {
+			[relation](gc_heap& a, stack_machine::args_view args) -> value_ {
 				for (const auto& disjunct : args) {
 					auto lhs = std::get<number>(args[0]);
 					auto rhs = std::get<number>(args[1]);
@@ -802,8 +1043,8 @@ void tess::relation_expr::compile(stack_machine::stack& stack) const
 			"<relation>"
 		)
 	);
-	lhs_->compile(stack);
-	rhs_->compile(stack);
+	lhs_->compile(stack, scope);
+	rhs_->compile(stack, scope);
 }
 
 void tess::relation_expr::get_dependencies(std::unordered_set<std::string>& dependencies) const
@@ -830,7 +1071,7 @@ tess::expr_ptr tess::nil_expr::simplify() const
 	return std::make_shared<nil_expr>();
 }
 
-void tess::nil_expr::compile(stack_machine::stack& stack) const
+void tess::nil_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
 	stack.push(value_{ nil_val() });
 }
@@ -853,16 +1094,16 @@ tess::if_expr::if_expr(expr_ptr condition, expr_ptr then_clause, expr_ptr else_c
 {
 }
 
-void tess::if_expr::compile(stack_machine::stack& stack) const
+void tess::if_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
 	stack_machine::stack then;
 	stack_machine::stack else_;
 
-	then_clause_->compile(then);
-	else_clause_->compile(else_);
+	then_clause_->compile(then, scope);
+	else_clause_->compile(else_, scope);
 
 	stack.push(std::make_shared<if_op>(then.pop_all(), else_.pop_all()));
-	condition_->compile(stack);
+	condition_->compile(stack, scope);
 }
 
 void tess::if_expr::get_dependencies(std::unordered_set<std::string>& dependencies) const
@@ -892,12 +1133,12 @@ tess::on_expr::on_expr(expr_ptr patch_expr, expr_ptr arg_expr) :
 {
 }
 
-void tess::on_expr::compile(stack_machine::stack& stack) const
+void tess::on_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
 	stack.push(
 		std::make_shared<val_func_op>(
 			2,
-			[](gc_heap& a, const std::vector<value_>& args) -> value_ {
+			[](gc_heap& a, stack_machine::args_view args) -> value_ {
 				std::variant<tess::const_tile_root_ptr, tess::const_patch_root_ptr> tile_or_patch = variant_cast(args[0]);
 				std::variant<tess::const_edge_root_ptr, tess::const_cluster_root_ptr> arg = variant_cast(args[1]);
 				return std::visit(
@@ -910,8 +1151,8 @@ void tess::on_expr::compile(stack_machine::stack& stack) const
 			"<on>"
 		)		
 	);
-	patch_expr_->compile(stack);
-	arg_expr_->compile(stack);
+	patch_expr_->compile(stack, scope);
+	arg_expr_->compile(stack, scope);
 }
 
 void tess::on_expr::get_dependencies(std::unordered_set<std::string>& dependencies) const
@@ -938,7 +1179,7 @@ tess::bool_lit_expr::bool_lit_expr(bool val) : val_(val)
 {
 }
 
-void tess::bool_lit_expr::compile(stack_machine::stack& stack) const
+void tess::bool_lit_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
 	stack.push(
 		tess::value_{ val_ }
@@ -964,7 +1205,7 @@ tess::clone_expr::clone_expr(expr_ptr clonee) : clonee_(clonee)
 {
 }
 
-void tess::clone_expr::compile(stack_machine::stack& stack) const
+void tess::clone_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
 	stack.push(
 		std::make_shared<one_param_op>(
@@ -974,7 +1215,7 @@ void tess::clone_expr::compile(stack_machine::stack& stack) const
 			"clone"
 		)
 	);
-	clonee_->compile(stack);
+	clonee_->compile(stack, scope);
 }
 
 void tess::clone_expr::get_dependencies(std::unordered_set<std::string>& dependencies) const
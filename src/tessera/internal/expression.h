@@ -24,7 +24,7 @@ namespace tess {
     class expression 
     {
     public:
-        virtual void compile(stack_machine::stack& stack) const = 0;
+        virtual void compile(stack_machine::stack& stack, stack_machine::scope& scope) const = 0;
         virtual std::string to_string() const = 0;
         virtual expr_ptr simplify() const = 0;
         virtual void get_dependencies(std::unordered_set<std::string>& dependencies) const = 0;
@@ -33,11 +33,12 @@ namespace tess {
     class number_expr : public expression
     {
     private:
-        int val_;
+        number val_;
     public:
         number_expr(int v);
-        number_expr(double v); 
-        void compile(stack_machine::stack& stack) const override;
+        number_expr(const number& v); 
+        const number& value() const { return val_; }
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         std::string to_string() const override;
         expr_ptr simplify() const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
@@ -49,7 +50,7 @@ namespace tess {
         std::string val_;
     public:
         string_expr(std::string str);
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         std::string to_string() const override;
         expr_ptr simplify() const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
@@ -68,7 +69,7 @@ namespace tess {
     public:
         special_number_expr(const std::string& v);
         special_number_expr(special_num which);
-        virtual void compile(stack_machine::stack& stack) const override;
+        virtual void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         expr_ptr simplify() const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
         std::string to_string() const override { return "<TODO>"; }
@@ -79,11 +80,14 @@ namespace tess {
     private:
         parser::kw func_;
         std::vector<expr_ptr> args_;
+        // set when simplify() has done the work of a call whose arguments are all 
+        // constant; a native that takes no arguments and only builds the result.
+        stack_machine::native_func precomputed_;
     public:
         special_function_expr(std::tuple<parser::kw, std::vector<expr_ptr>> param);
         special_function_expr(parser::kw, expr_ptr args);
-        special_function_expr(parser::kw, const std::vector<expr_ptr>& args);
-        void compile(stack_machine::stack& stack) const override;
+        special_function_expr(parser::kw, const std::vector<expr_ptr>& args, stack_machine::native_func precomputed = {});
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
         expr_ptr simplify() const override;
         std::string to_string() const override;
@@ -99,7 +103,7 @@ namespace tess {
     public:
         exponent_expr(const expression_params& params);
         exponent_expr(expr_ptr base, const std::vector<expr_ptr>& exponents);
-        virtual void compile(stack_machine::stack& stack) const override;
+        virtual void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
         expr_ptr simplify() const override;
         std::string to_string() const override { return "<TODO>"; }
@@ -112,7 +116,7 @@ namespace tess {
     public:
         addition_expr(const expression_params& terms);
         addition_expr(const std::vector<std::tuple<bool, expr_ptr>>& terms);
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         std::string to_string() const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
         expr_ptr simplify() const override;
@@ -125,7 +129,7 @@ namespace tess {
     public:
         multiplication_expr(const expression_params& factors);
         multiplication_expr(const std::vector<std::tuple<bool, expr_ptr>>& factors);
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
         expr_ptr simplify() const override;
         std::string to_string() const override;
@@ -138,7 +142,7 @@ namespace tess {
     public:
         bool_lit_expr(bool val);
         bool_lit_expr(const std::string& keyword);
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
         expr_ptr simplify() const override;
         std::string to_string() const override;
@@ -150,7 +154,7 @@ namespace tess {
 		std::vector<expr_ptr> conjuncts_;
 	public:
 		and_expr(const std::vector<expr_ptr>& conjuncts);
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
         expr_ptr simplify() const override;
         std::string to_string() const override { return "<TODO>"; }
@@ -162,7 +166,7 @@ namespace tess {
 		std::vector<expr_ptr> disjuncts_;
 	public:
 		or_expr(const std::vector<expr_ptr> disjuncts);
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
         expr_ptr simplify() const override;
         std::string to_string() const override { return "<TODO>"; }
@@ -174,7 +178,7 @@ namespace tess {
 		std::vector<expr_ptr> operands_;
 	public:
 		equality_expr(const std::vector<expr_ptr> operands);
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
         expr_ptr simplify() const override;
         std::string to_string() const override { return "<TODO>"; }
@@ -198,7 +202,7 @@ namespace tess {
 	public:
 		relation_expr(std::tuple<expr_ptr, std::string, expr_ptr> param);
         relation_expr(expr_ptr lhs, relation_op op, expr_ptr rhs);
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
         expr_ptr simplify() const override;
         std::string to_string() const override { return "<TODO>"; }
@@ -209,7 +213,7 @@ namespace tess {
 	public:
 		nil_expr();
         expr_ptr simplify() const override;
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
         std::string to_string() const override { return "(nil)"; }
 	};
@@ -223,7 +227,7 @@ namespace tess {
     public:
         if_expr(std::tuple< expr_ptr, expr_ptr, expr_ptr> exprs);
         if_expr(expr_ptr condition, expr_ptr then_clause, expr_ptr else_clause);
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
         expr_ptr simplify() const override;
         std::string to_string() const override;
@@ -236,7 +240,7 @@ namespace tess {
         expr_ptr arg_expr_;
     public:
         on_expr(expr_ptr patch_expr, expr_ptr arg_expr);
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
         expr_ptr simplify() const override;
         std::string to_string() const override;
@@ -248,7 +252,7 @@ namespace tess {
         expr_ptr clonee_;
     public:
         clone_expr(expr_ptr clonee);
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
         expr_ptr simplify() const override;
         std::string to_string() const override;
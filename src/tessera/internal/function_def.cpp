@@ -7,13 +7,33 @@
 #include <unordered_set>
 #include <numeric>
 
-void tess::function_def::compile(stack_machine::stack& stack) const
+void tess::function_def::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
+    std::unordered_set<std::string> dep_set;
+    get_dependencies(dep_set);
+    std::vector<std::string> deps(dep_set.begin(), dep_set.end());
+
+    // the body runs in its own evaluation context, starting with a frame holding the 
+    // arguments followed by the closure.
+    auto id = scope.next_lambda_id();
+    auto body_scope = scope.nested();
+    body_scope.push_frame();
+    for (const auto& param : parameters_)
+        body_scope.declare(param);
+    for (const auto& dep : deps)
+        body_scope.declare(dep);
+
     stack_machine::stack body;
-    body_->compile(body);
-    std::unordered_set<std::string> deps;
-    get_dependencies(deps);
-    stack.push(std::make_shared<make_lambda>(parameters_, body.pop_all(), std::vector<std::string>(deps.begin(), deps.end())));
+    body_->compile(body, body_scope);
+
+    std::vector<stack_machine::variable> captures(deps.size());
+    std::transform(deps.begin(), deps.end(), captures.begin(),
+        [&scope](const auto& dep) {
+            return scope.resolve(dep);
+        }
+    );
+
+    stack.push(std::make_shared<make_lambda>(id, parameters_, body.pop_all(), deps, captures));
 }
 
 std::string tess::function_def::to_string() const
@@ -15,7 +15,7 @@ namespace tess {
 
     class function_def : public expression {
         public:
-            void compile(stack_machine::stack& stack) const override;
+            void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
             std::string to_string() const override;
             const std::vector<std::string>& parameters() const;
             expr_ptr body() const;
@@ -2,8 +2,57 @@
 #include "lambda_impl.h"
 #include "tile_impl.h"
 #include "tile_patch_impl.h"
+#include <chrono>
+#include <algorithm>
 
-tess::gc_heap::gc_heap() : allocations_since_collection_(0)
+tess::gc_heap::gc_heap(const gc_options& options) : 
+    options_(options),
+    allocations_since_collection_(0),
+    full_collection_threshold_(static_cast<size_t>(options.young_generation_size * options.heap_growth_factor))
 {
     
 }
+
+void tess::gc_heap::collect()
+{
+    auto start = std::chrono::steady_clock::now();
+    auto size_before = impl_.size();
+
+    if (options_.generational) {
+        impl_.collect_young();
+        ++stats_.minor_collections;
+    }
+    if (!options_.generational || impl_.size() > full_collection_threshold_) {
+        impl_.collect();
+        ++stats_.full_collections;
+        full_collection_threshold_ = std::max(
+            static_cast<size_t>(options_.young_generation_size),
+            static_cast<size_t>(impl_.size() * options_.heap_growth_factor)
+        );
+    }
+    allocations_since_collection_ = 0;
+
+    std::chrono::duration<double> pause = std::chrono::steady_clock::now() - start;
+    stats_.objects_freed += size_before - impl_.size();
+    stats_.last_pause = pause.count();
+    stats_.total_pause += stats_.last_pause;
+    stats_.max_pause = std::max(stats_.max_pause, stats_.last_pause);
+}
+
+size_t tess::gc_heap::size() const
+{
+    return impl_.size();
+}
+
+const tess::gc_stats& tess::gc_heap::stats() const
+{
+    return stats_;
+}
+
+void tess::gc_heap::adopt(gc_heap& other)
+{
+    // the adopted objects are young, so they count toward the next collection.
+    auto n = other.size();
+    impl_.adopt(other.impl_);
+    allocations_since_collection_ += static_cast<int>(n);
+}
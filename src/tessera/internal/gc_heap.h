@@ -24,18 +24,36 @@ namespace tess {
     template <typename T>
     using enable_self_ptr = graph_pool::enable_self_graph_ptr<T>;
 
+    struct gc_options {
+        // if false every collection is a full collection.
+        bool generational = true;
+        // allocations between collections, i.e. the size of the young generation.
+        int young_generation_size = 100000;
+        // a full collection is done when the heap has grown by this factor since 
+        // the last full collection.
+        double heap_growth_factor = 2.0;
+    };
+
+    // pause times are in seconds.
+    struct gc_stats {
+        int minor_collections = 0;
+        int full_collections = 0;
+        size_t objects_freed = 0;
+        double total_pause = 0.0;
+        double max_pause = 0.0;
+        double last_pause = 0.0;
+    };
+
     class gc_heap {
 
     public:
 
-        gc_heap();
+        gc_heap(const gc_options& options = {});
 
         template<typename T, typename... Args>
         auto make_mutable(Args&&... args) {
-            if (allocations_since_collection_++ > k_collection_freq) {
-                impl_.collect();
-                allocations_since_collection_ = 0;
-            }
+            if (allocations_since_collection_++ > options_.young_generation_size) 
+                collect();
 
             auto ptr = impl_.make_root<typename std::remove_const<typename T::value_type>::type>();
             call_initialize(ptr, std::forward<Args>(args)...);
@@ -57,6 +75,15 @@ namespace tess {
             return graph_ptr<obj_type>(u, root);
         }
 
+        void collect();
+        size_t size() const;
+        const gc_stats& stats() const;
+
+        // takes over every object of other without copying, leaving other empty. A heap
+        // is used by one thread at a time: a worker can build values in a heap of its 
+        // own and its caller adopt them once the worker is done.
+        void adopt(gc_heap& other);
+
     private:
 
         template<typename P, typename... Args>
@@ -69,9 +96,10 @@ namespace tess {
         }
 
         graph_pool impl_;
+        gc_options options_;
+        gc_stats stats_;
         int allocations_since_collection_;
-
-        const int k_collection_freq = 100000;
+        size_t full_collection_threshold_;
 
     };
 
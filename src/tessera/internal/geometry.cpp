@@ -5,7 +5,9 @@
 #include "tessera/tile_patch.h"
 #include "tessera_impl.h"
 #include "tile_impl.h"
+#include "thread_pool.h"
 #include <unordered_set>
+#include <algorithm>
 
 namespace geom = tess::geometry;
 
@@ -133,6 +135,48 @@ namespace {
 		return box_from_points(x1, y1, x2, y2);
 	}
 
+	std::vector<geom::rtree_value> make_rtree_values(const std::vector<tess::point>& pts) {
+		std::vector<geom::rtree_value> values(pts.size());
+		for (int i = 0; i < static_cast<int>(pts.size()); ++i)
+			values[i] = geom::rtree_value(make_rtree_point(pts[i]), i);
+		return values;
+	}
+
+	// maps each point to the index of the earliest point within eps of it that
+	// is not itself merged with an earlier point, i.e. the result of inserting
+	// the points one at a time, using a single packed rtree.
+	std::vector<int> merge_points(const std::vector<tess::point>& pts, tess::number eps) {
+#ifdef TESSERA_GRID_VERTEX_TABLE
+		// grid inserts are already constant time so just insert one at a time.
+		geom::grid_tbl tbl(eps);
+		std::vector<int> merged_into(pts.size());
+		std::vector<int> first_of;
+		for (int i = 0; i < static_cast<int>(pts.size()); ++i) {
+			int index = tbl.insert(pts[i]);
+			if (index == static_cast<int>(first_of.size()))
+				first_of.push_back(i);
+			merged_into[i] = first_of[index];
+		}
+		return merged_into;
+#else
+		geom::rtree tree(make_rtree_values(pts));
+		std::vector<int> merged_into(pts.size());
+		std::vector<geom::rtree_value> items;
+		for (int i = 0; i < static_cast<int>(pts.size()); ++i) {
+			items.clear();
+			tree.query(geom::bgi::within(pad_point(pts[i], eps)), std::back_inserter(items));
+			merged_into[i] = i;
+			for (const auto& [key, j] : items)
+				if (j < merged_into[i] && merged_into[j] == j)
+					merged_into[i] = j;
+		}
+		return merged_into;
+#endif
+	}
+
+	// unions the polygons pairwise, level by level, on the shared thread pool. 
+	// Intermediate results are multipolygons since polygons that are not adjacent
+	// in the DFS order need not touch.
 	std::optional<geom::polygon> join_polygons(const std::vector<geom::polygon>& polygons) {
 
 		if (polygons.empty())
@@ -141,17 +185,28 @@ namespace {
 		if (polygons.size() == 1)
 			return polygons.front();
 
-		geom::polygon joined_so_far = polygons.front();
-		for (auto i = polygons.begin() + 1; i != polygons.end(); ++i) {
-			const auto& polygon = *i;
-			std::vector<geom::polygon> joined;
-			geom::bg::union_(joined_so_far, polygon, joined);
-			if (joined.size() != 1)
-				return std::nullopt;
-			joined_so_far = joined.front();
+		std::vector<geom::multi_polygon> level(polygons.size());
+		for (size_t i = 0; i < polygons.size(); ++i)
+			level[i].push_back(polygons[i]);
+
+		auto& pool = tess::thread_pool::shared();
+		while (level.size() > 1) {
+			int pairs = static_cast<int>(level.size() / 2);
+			std::vector<geom::multi_polygon> next_level((level.size() + 1) / 2);
+			pool.parallel_for(pairs,
+				[&](int i) {
+					geom::bg::union_(level[2 * i], level[2 * i + 1], next_level[i]);
+				}
+			);
+			if (level.size() % 2 == 1)
+				next_level.back() = std::move(level.back());
+			level = std::move(next_level);
 		}
 
-		return joined_so_far;
+		if (level.front().size() != 1)
+			return std::nullopt;
+
+		return level.front().front();
 	}
 
 	geom::polygon vertices_to_polygon(const std::vector<tess::const_vertex_root_ptr>& vertices) {
@@ -198,6 +253,72 @@ namespace {
 		return polygons;
 	}
 
+	tess::number signed_area(const std::vector<tess::point>& poly) {
+		tess::number area = 0;
+		for (int i = 0; i < static_cast<int>(poly.size()); ++i) {
+			auto [x1, y1] = poly[i];
+			auto [x2, y2] = poly[(i + 1) % poly.size()];
+			area += x1 * y2 - x2 * y1;
+		}
+		return area / tess::number(2);
+	}
+
+	// tiles in a patch share vertex indices, so if they meet edge-to-edge the 
+	// outline of their union is what is left after cancelling each half-edge (u,v) 
+	// against an opposite half-edge (v,u). Returns nullopt if what is left is not a 
+	// single cycle enclosing the same area as the tiles, e.g. because of T-junctions, 
+	// holes, or disconnected tiles.
+	std::optional<std::vector<tess::point>> join_by_edge_cancellation(tess::const_patch_root_ptr patch) {
+		std::unordered_map<tess::edge_indices, int, tess::edge_hash> half_edges;
+		std::vector<tess::edge_indices> ordered_half_edges;
+		tess::number tiles_area = 0;
+		for (auto i = patch->begin_tiles(); i != patch->end_tiles(); ++i) {
+			const auto& tile = *i;
+			for (auto j = tile->begin_edges(); j != tile->end_edges(); ++j) {
+				const auto& e = *j;
+				auto key = e->get_edge_location_indices();
+				if (++half_edges[key] > 1)
+					return std::nullopt;
+				ordered_half_edges.push_back(key);
+				auto [x1, y1] = e->u()->pos();
+				auto [x2, y2] = e->v()->pos();
+				tiles_area += (x1 * y2 - x2 * y1) / tess::number(2);
+			}
+		}
+
+		std::unordered_map<int, int> next;
+		int start = -1;
+		for (const auto& [u, v] : ordered_half_edges) {
+			if (half_edges.find({ v, u }) != half_edges.end())
+				continue;
+			if (!next.insert({ u, v }).second)
+				return std::nullopt;
+			if (start == -1)
+				start = u;
+		}
+		if (start == -1)
+			return std::nullopt;
+
+		std::vector<tess::point> outline;
+		outline.reserve(next.size());
+		int u = start;
+		do {
+			auto iter = next.find(u);
+			if (iter == next.end() || outline.size() == next.size())
+				return std::nullopt;
+			outline.push_back(patch->get_vertex_location(u));
+			u = iter->second;
+		} while (u != start);
+		if (outline.size() != next.size())
+			return std::nullopt;
+
+		auto area = signed_area(outline);
+		if (tess::abs(area - tiles_area) > tess::eps * std::max(tess::number(1), tess::abs(tiles_area)))
+			return std::nullopt;
+
+		return outline;
+	}
+
 	bool is_closed_poly(const std::vector<tess::point>& poly) {
 		return tess::equals(poly.front(), poly.back());
 	}
@@ -236,9 +357,18 @@ namespace {
 
 geom::rtree_tbl::rtree_tbl(tess::number eps) : eps_(eps) {}
 
+geom::rtree_tbl::rtree_tbl(tess::number eps, const std::vector<tess::point>& pts) : 
+	eps_(eps),
+	tree_(make_rtree_values(pts))
+{}
+
 std::optional<int> geom::rtree_tbl::get(const tess::point& pt) const {
+	return get(pt, eps_);
+}
+
+std::optional<int> geom::rtree_tbl::get(const tess::point& pt, tess::number eps) const {
 	std::vector<geom::rtree_value> items;
-	tree_.query(geom::bgi::within(pad_point(pt, eps_)), std::back_inserter(items));
+	tree_.query(geom::bgi::within(pad_point(pt, eps)), std::back_inserter(items));
 	if (items.empty())
 		return std::nullopt;
 	if (items.size() == 1)
@@ -247,7 +377,11 @@ std::optional<int> geom::rtree_tbl::get(const tess::point& pt) const {
 }
 
 int geom::rtree_tbl::insert(const tess::point& pt) {
-	auto maybe_index = get(pt);
+	return insert(pt, eps_);
+}
+
+int geom::rtree_tbl::insert(const tess::point& pt, tess::number eps) {
+	auto maybe_index = get(pt, eps);
 	if (maybe_index.has_value())
 		return maybe_index.value();
 	int new_index = static_cast<int>(tree_.size());
@@ -262,15 +396,150 @@ void geom::rtree_tbl::clear() {
 	tree_.clear();
 }
 
+geom::grid_tbl::grid_tbl(tess::number eps) : 
+	eps_(eps),
+	cell_size_(static_cast<double>(eps))
+{}
+
+geom::grid_tbl::grid_tbl(tess::number eps, const std::vector<tess::point>& pts) :
+	grid_tbl(eps)
+{
+	pts_ = pts;
+	cells_.reserve(pts.size());
+	for (int i = 0; i < static_cast<int>(pts_.size()); ++i) {
+		auto [x, y] = pts_[i];
+		cells_[{to_cell_coord(x), to_cell_coord(y)}].push_back(i);
+	}
+}
+
+std::size_t geom::grid_tbl::cell_hash::operator()(const cell& c) const {
+	std::size_t seed = 0;
+	boost::hash_combine(seed, std::get<0>(c));
+	boost::hash_combine(seed, std::get<1>(c));
+	return seed;
+}
+
+int64_t geom::grid_tbl::to_cell_coord(tess::number v) const {
+	return static_cast<int64_t>(std::floor(static_cast<double>(v) / cell_size_));
+}
+
+void geom::grid_tbl::regrid(tess::number eps) const {
+	cell_size_ = static_cast<double>(eps);
+	cells_.clear();
+	for (int i = 0; i < static_cast<int>(pts_.size()); ++i) {
+		auto [x, y] = pts_[i];
+		cells_[{to_cell_coord(x), to_cell_coord(y)}].push_back(i);
+	}
+}
+
+std::optional<int> geom::grid_tbl::get(const tess::point& pt) const {
+	return get(pt, eps_);
+}
+
+std::optional<int> geom::grid_tbl::get(const tess::point& pt, tess::number eps) const {
+	// keep the number of cells probed small if the query epsilon has grown, 
+	// e.g. because the table is in the local frame of a patch that has shrunk.
+	if (static_cast<double>(eps) > 4.0 * cell_size_)
+		regrid(eps);
+
+	auto [x, y] = pt;
+	tess::number padding = eps / tess::number(2);
+	std::optional<int> found;
+	for (auto i = to_cell_coord(x - padding); i <= to_cell_coord(x + padding); ++i) {
+		for (auto j = to_cell_coord(y - padding); j <= to_cell_coord(y + padding); ++j) {
+			auto iter = cells_.find({ i, j });
+			if (iter == cells_.end())
+				continue;
+			for (int index : iter->second) {
+				auto [px, py] = pts_[index];
+				if (tess::abs(px - x) < padding && tess::abs(py - y) < padding) {
+					if (found.has_value())
+						throw tess::error("invalid vertex table");
+					found = index;
+				}
+			}
+		}
+	}
+	return found;
+}
+
+int geom::grid_tbl::insert(const tess::point& pt) {
+	return insert(pt, eps_);
+}
+
+int geom::grid_tbl::insert(const tess::point& pt, tess::number eps) {
+	auto maybe_index = get(pt, eps);
+	if (maybe_index.has_value())
+		return maybe_index.value();
+	int new_index = static_cast<int>(pts_.size());
+	pts_.push_back(pt);
+	auto [x, y] = pt;
+	cells_[{to_cell_coord(x), to_cell_coord(y)}].push_back(new_index);
+	return new_index;
+}
+
+void geom::grid_tbl::clear() {
+	pts_.clear();
+	cells_.clear();
+}
+
 
 
 tess::vertex_location_table::vertex_location_table() :
-	pt_to_index_(std::numeric_limits<float>::epsilon())
+	transform_(matrix::Identity()),
+	inverse_(matrix::Identity()),
+	scale_(1),
+	is_exact_(true),
+	exact_order_(1)
 {}
 
-int tess::vertex_location_table::get_index(const tess::point& pt) const
+const geom::point_tbl& tess::vertex_location_table::pt_to_index() const
+{
+	if (!pt_to_index_.has_value()) {
+		pt_to_index_ = geom::point_tbl(local_eps(), index_to_pt_);
+	}
+	return *pt_to_index_;
+}
+
+tess::point tess::vertex_location_table::to_local(const tess::point& pt) const
+{
+	return apply_matrix(inverse_, pt);
+}
+
+tess::number tess::vertex_location_table::local_eps() const
+{
+	return tess::number(std::numeric_limits<float>::epsilon()) / scale_;
+}
+
+std::optional<int> tess::vertex_location_table::find_exact(const cyclotomic& exact_pt) const
 {
-	auto maybe_index = pt_to_index_.get(pt);
+	auto local_pt = exact_inverse_.apply(exact_pt);
+	if (exact_order_ % local_pt.order() != 0)
+		return std::nullopt;
+	auto iter = exact_to_index_.find(local_pt.lift(exact_order_));
+	if (iter == exact_to_index_.end())
+		return std::nullopt;
+	return iter->second;
+}
+
+void tess::vertex_location_table::drop_exact_locations()
+{
+	is_exact_ = false;
+	index_to_exact_.clear();
+	exact_to_index_.clear();
+}
+
+int tess::vertex_location_table::get_index(const tess::point& pt, const std::optional<cyclotomic>& exact_pt) const
+{
+	if (is_exact_ && exact_pt.has_value()) {
+		try {
+			auto maybe_index = find_exact(*exact_pt);
+			if (maybe_index.has_value())
+				return maybe_index.value();
+		} catch (const cyclotomic_overflow&) {
+		}
+	}
+	auto maybe_index = pt_to_index().get(to_local(pt), local_eps());
 	if (!maybe_index.has_value())
 		throw tess::error("Bad vertex table look up");
 	return maybe_index.value();
@@ -278,32 +547,117 @@ int tess::vertex_location_table::get_index(const tess::point& pt) const
 
 tess::point tess::vertex_location_table::get_location(int index) const
 {
-	return index_to_pt_.at(index);
+	return apply_matrix(transform_, index_to_pt_.at(index));
+}
+
+std::optional<tess::cyclotomic> tess::vertex_location_table::get_exact_location(int index) const
+{
+	if (!is_exact_)
+		return std::nullopt;
+	try {
+		return exact_transform_.apply(index_to_exact_.at(index));
+	} catch (const cyclotomic_overflow&) {
+		return std::nullopt;
+	}
 }
 
-int tess::vertex_location_table::insert(const tess::point& pt)
+int tess::vertex_location_table::insert(const tess::point& pt, const std::optional<cyclotomic>& exact_pt)
 {
-	int index = pt_to_index_.insert(pt);
 	int n = static_cast<int>(index_to_pt_.size());
+	if (is_exact_ && exact_pt.has_value()) {
+		try {
+			auto local_pt = exact_inverse_.apply(*exact_pt);
+			auto order = common_order(exact_order_, local_pt.order());
+			if (order != exact_order_) {
+				exact_to_index_.clear();
+				for (int i = 0; i < n; ++i) {
+					index_to_exact_[i] = index_to_exact_[i].lift(order);
+					exact_to_index_[index_to_exact_[i]] = i;
+				}
+				exact_order_ = order;
+			}
+			auto key = local_pt.lift(exact_order_);
+			auto iter = exact_to_index_.find(key);
+			if (iter != exact_to_index_.end())
+				return iter->second;
+
+			auto local_float_pt = key.to_point();
+			exact_to_index_[key] = n;
+			index_to_exact_.push_back(key);
+			index_to_pt_.push_back(local_float_pt);
+			if (pt_to_index_.has_value())
+				pt_to_index_->insert(local_float_pt, local_eps());
+			return n;
+		} catch (const cyclotomic_overflow&) {
+		}
+	}
+	if (is_exact_)
+		drop_exact_locations();
+
+	auto local_pt = to_local(pt);
+	pt_to_index();
+	int index = pt_to_index_->insert(local_pt, local_eps());
 	if (index < n)
 		return index; // TODO: possibly make the point in the table the average of pt and what was already there
 	if (index > n)
 		throw error("Corrupt vertex table.");
-	index_to_pt_.push_back(pt);
+	index_to_pt_.push_back(local_pt);
 	return n;
 }
 
-void tess::vertex_location_table::apply_transformation(const matrix& mat)
+std::vector<int> tess::vertex_location_table::insert(const std::vector<tess::point>& pts, const std::vector<std::optional<cyclotomic>>& exact_pts)
 {
-	std::vector<tess::point> new_index_to_pt_(index_to_pt_.size());
-	std::transform(index_to_pt_.begin(), index_to_pt_.end(), new_index_to_pt_.begin(),
-		[&mat](const auto& p) { return tess::apply_matrix(mat, p);  }
-	);
-	index_to_pt_ = new_index_to_pt_;
+	std::vector<int> indices;
+	indices.reserve(pts.size());
+	bool all_exact = is_exact_ && 
+		std::all_of(exact_pts.begin(), exact_pts.end(), [](const auto& e) {return e.has_value(); });
+	if (all_exact || !index_to_pt_.empty()) {
+		for (int i = 0; i < static_cast<int>(pts.size()); ++i)
+			indices.push_back(insert(pts[i], exact_pts[i]));
+		return indices;
+	}
 
-	pt_to_index_.clear();
-	for (const auto& p : index_to_pt_)
-		pt_to_index_.insert(p);
+	// inserting into an empty table without exact locations: merge the points 
+	// and bulk load the rtree rather than inserting one point at a time.
+	drop_exact_locations();
+	std::vector<tess::point> local_pts(pts.size());
+	std::transform(pts.begin(), pts.end(), local_pts.begin(), [this](const auto& pt) {return to_local(pt); });
+	auto merged_into = merge_points(local_pts, local_eps());
+	for (int i = 0; i < static_cast<int>(local_pts.size()); ++i) {
+		if (merged_into[i] == i) {
+			indices.push_back(static_cast<int>(index_to_pt_.size()));
+			index_to_pt_.push_back(local_pts[i]);
+		} else {
+			indices.push_back(indices[merged_into[i]]);
+		}
+	}
+	pt_to_index_ = geom::point_tbl(local_eps(), index_to_pt_);
+	return indices;
+}
+
+void tess::vertex_location_table::apply_transformation(const matrix& mat, const std::optional<exact_transform>& exact)
+{
+	if (index_to_pt_.empty())
+		return;
+
+	// the locations themselves are left alone; only the transformation from 
+	// the local frame to the patch's frame is updated.
+	transform_ = mat * transform_;
+	inverse_ = transform_.inverse();
+	scale_ = tess::sqrt(tess::abs(transform_(0, 0) * transform_(1, 1) - transform_(0, 1) * transform_(1, 0)));
+
+	if (!is_exact_)
+		return;
+	if (exact.has_value()) {
+		try {
+			auto exact_transform = *exact * exact_transform_;
+			exact_inverse_ = exact_transform.inverse();
+			exact_transform_ = exact_transform;
+			return;
+		} catch (const cyclotomic_overflow&) {
+		}
+	}
+	drop_exact_locations();
 }
 
 std::size_t tess::edge_hash::operator()(const edge_indices& key) const
@@ -313,6 +667,10 @@ std::size_t tess::edge_hash::operator()(const edge_indices& key) const
 
 std::vector<tess::point> tess::join(tess::const_patch_root_ptr tiles)
 {
+	auto outline = join_by_edge_cancellation(tiles);
+	if (outline.has_value())
+		return shrink_wrap(*outline);
+
 	auto ordered_tiles = topological_sort_tiles(tiles);
 	auto maybe_polygon = join_polygons(tile_patch_to_polygons(ordered_tiles));
 
@@ -356,6 +714,16 @@ tess::edge_location_table::edge_location_table(number eps) :
 {
 }
 
+tess::edge_location_table::edge_location_table(const std::vector<tess::const_edge_root_ptr>& edges, number eps) :
+	eps_(eps)
+{
+	std::vector<geometry::segment_rtree_value> values;
+	values.reserve(edges.size());
+	for (const auto& edge : edges)
+		values.emplace_back(edge_to_seg(edge), edge);
+	impl_ = geometry::segment_rtree(values);
+}
+
 void tess::edge_location_table::insert(tess::const_edge_root_ptr edge)
 {
 	geometry::segment_rtree_value pair{ edge_to_seg(edge), edge };
@@ -4,6 +4,7 @@
 #include "tessera/tile.h"
 #include "tessera/tile_patch.h"
 #include "number.h"
+#include "cyclotomic.h"
 #include <boost/geometry.hpp>
 #include <boost/geometry/index/rtree.hpp>
 #include <unordered_map>
@@ -21,6 +22,7 @@ namespace tess {
         using rtree = bgi::rtree<rtree_value, bgi::rstar<8>>; //bgi::rtree<rtree_value, bgi::quadratic<16>>;
         using point = bg::model::d2::point_xy<double>;
         using polygon = bg::model::polygon<point, false>;
+        using multi_polygon = bg::model::multi_polygon<polygon>;
         using segment = bg::model::segment<point>;
         using segment_rtree_value = std::pair<segment, tess::const_edge_root_ptr>;
         using segment_rtree = bgi::rtree<segment_rtree_value, bgi::quadratic<16>>;
@@ -29,8 +31,12 @@ namespace tess {
         {
         public:
             rtree_tbl(tess::number eps);
+            // bulk loads distinct points, the index of each being its position in pts.
+            rtree_tbl(tess::number eps, const std::vector<tess::point>& pts);
             std::optional<int> get(const tess::point& pt) const;
+            std::optional<int> get(const tess::point& pt, tess::number eps) const;
             int insert(const tess::point& pt);
+            int insert(const tess::point& pt, tess::number eps);
             void clear();
 
         private:
@@ -38,23 +44,81 @@ namespace tess {
             rtree tree_;
         };
 
+        // uniform grid hash keyed on coordinates quantized to cells of size eps, 
+        // probing the cells a padded point overlaps; an alternative to rtree_tbl 
+        // selected with the TESSERA_GRID_VERTEX_TABLE option.
+        class grid_tbl
+        {
+        public:
+            grid_tbl(tess::number eps);
+            grid_tbl(tess::number eps, const std::vector<tess::point>& pts);
+            std::optional<int> get(const tess::point& pt) const;
+            std::optional<int> get(const tess::point& pt, tess::number eps) const;
+            int insert(const tess::point& pt);
+            int insert(const tess::point& pt, tess::number eps);
+            void clear();
+
+        private:
+            using cell = std::tuple<int64_t, int64_t>;
+            struct cell_hash {
+                std::size_t operator()(const cell& c) const;
+            };
+            int64_t to_cell_coord(tess::number v) const;
+            void regrid(tess::number eps) const;
+
+            tess::number eps_;
+            std::vector<tess::point> pts_;
+            mutable double cell_size_;
+            mutable std::unordered_map<cell, std::vector<int>, cell_hash> cells_;
+        };
+
+#ifdef TESSERA_GRID_VERTEX_TABLE
+        using point_tbl = grid_tbl;
+#else
+        using point_tbl = rtree_tbl;
+#endif
+
     };
 
+    // maps vertex locations to indices. Locations are held in a local frame along 
+    // with a pending transformation to the patch's frame, so moving a patch is O(1) 
+    // and lookups map the query point back into the local frame. While every 
+    // location inserted has exact cyclotomic coordinates, lookups are exact hash 
+    // lookups and the point table used for epsilon matching of floating point 
+    // locations is only built on demand.
     class vertex_location_table {
     public:
         vertex_location_table();
-        int get_index(const tess::point& pt) const;
+        int get_index(const tess::point& pt, const std::optional<cyclotomic>& exact_pt = std::nullopt) const;
         tess::point get_location(int index) const;
-        int insert(const tess::point& pt);
-        void apply_transformation(const matrix& mat);
+        std::optional<cyclotomic> get_exact_location(int index) const;
+        int insert(const tess::point& pt, const std::optional<cyclotomic>& exact_pt = std::nullopt);
+        std::vector<int> insert(const std::vector<tess::point>& pts, const std::vector<std::optional<cyclotomic>>& exact_pts);
+        void apply_transformation(const matrix& mat, const std::optional<exact_transform>& exact = std::nullopt);
     private:
-        geometry::rtree_tbl pt_to_index_;
+        const geometry::point_tbl& pt_to_index() const;
+        std::optional<int> find_exact(const cyclotomic& exact_pt) const;
+        void drop_exact_locations();
+        tess::point to_local(const tess::point& pt) const;
+        tess::number local_eps() const;
+
+        mutable std::optional<geometry::point_tbl> pt_to_index_;
         std::vector<tess::point> index_to_pt_;
+        matrix transform_;
+        matrix inverse_;
+        tess::number scale_;
+        bool is_exact_;
+        int exact_order_;
+        exact_transform exact_transform_;
+        exact_transform exact_inverse_;
+        std::vector<cyclotomic> index_to_exact_;
+        std::unordered_map<cyclotomic, int, cyclotomic_hash> exact_to_index_;
     };
 
     class edge_location_table {
     public:
         edge_location_table(number eps = tess::eps);
+        edge_location_table(const std::vector<tess::const_edge_root_ptr>& edges, number eps = tess::eps);
         void insert(tess::const_edge_root_ptr edge);
         std::vector<tess::const_edge_root_ptr> get(tess::point a, tess::point b);
         std::vector<tess::const_edge_root_ptr> get(const tess::edge& edge);
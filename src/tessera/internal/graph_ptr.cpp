@@ -1,68 +1,243 @@
 #include "graph_ptr.h"
 
-void gp::detail::graph::insert_edge(void* ptr_u, void* ptr_v) {
-    auto& u = get_or_create(ptr_u);
-    auto& v = get_or_create(ptr_v);
-    auto iter = u.find(ptr_v);
-    if (iter == u.end()) {
-        u.insert(ptr_v);
+bool gp::detail::edge_list::insert(node_id v) {
+    if (overflow_)
+        return ((*overflow_)[v]++ == 0);
+
+    for (uint32_t i = 0; i < size_; ++i) {
+        if (inline_[i].v == v) {
+            inline_[i].count++;
+            return false;
+        }
     }
+    if (size_ < k_inline_edges) {
+        inline_[size_++] = { v, 1 };
+        return true;
+    }
+
+    overflow_ = std::make_unique<std::unordered_map<node_id, uint32_t>>();
+    for (uint32_t i = 0; i < size_; ++i)
+        (*overflow_)[inline_[i].v] = inline_[i].count;
+    (*overflow_)[v] = 1;
+    size_ = 0;
+    return true;
 }
 
-void gp::detail::graph::remove_edge(void* u, void* v) {
-    auto i = impl_.find(u);
-    if (i == impl_.end())
+void gp::detail::edge_list::remove(node_id v) {
+    if (overflow_) {
+        auto iter = overflow_->find(v);
+        if (iter != overflow_->end() && --iter->second == 0)
+            overflow_->erase(iter);
         return;
-    auto& a_list = i->second;
-    auto j = a_list.find(v);
-    if (j != a_list.end())
-        a_list.erase(j);
+    }
+
+    for (uint32_t i = 0; i < size_; ++i) {
+        if (inline_[i].v == v) {
+            if (--inline_[i].count == 0)
+                inline_[i] = inline_[--size_];
+            return;
+        }
+    }
+}
+
+void gp::detail::edge_list::clear() {
+    size_ = 0;
+    overflow_.reset();
 }
 
-std::unordered_set<void*> gp::detail::graph::collect(const std::unordered_map<void*, int> roots) {
-    std::unordered_set<void*> live;
-    for (auto [root, count] : roots) {
-        find_live_set(root, live);
+void gp::detail::edge_list::relabel(const std::vector<node_id>& ids) {
+    if (overflow_) {
+        std::unordered_map<node_id, uint32_t> relabeled;
+        for (const auto& [v, count] : *overflow_)
+            relabeled[ids[v]] = count;
+        *overflow_ = std::move(relabeled);
+        return;
     }
+    for (uint32_t i = 0; i < size_; ++i)
+        inline_[i].v = ids[inline_[i].v];
+}
 
-    for (auto it = impl_.begin(); it != impl_.end();) {
-        if (live.find(it->first) == live.end()) {
-            it = impl_.erase(it);
-        }
-        else {
-            it++;
-        }
+gp::detail::node_id gp::detail::graph::create_node() {
+    node_id v;
+    if (!free_ids_.empty()) {
+        v = free_ids_.back();
+        free_ids_.pop_back();
+        auto& n = nodes_[v];
+        n.roots = 0;
+        n.old = false;
+        n.marked = false;
+        n.remembered = false;
+        n.in_use = true;
+        n.shared = false;
+    } else {
+        v = static_cast<node_id>(nodes_.size());
+        nodes_.emplace_back();
     }
+    young_.push_back(v);
+    return v;
+}
+
+void gp::detail::graph::insert_edge(node_id u, node_id v) {
+    auto& u_node = nodes_[u];
+    if (u_node.edges.insert(v) && u_node.old && !nodes_[v].old && !u_node.remembered) {
+        u_node.remembered = true;
+        remembered_.push_back(u);
+    }
+}
+
+void gp::detail::graph::remove_edge(node_id u, node_id v) {
+    nodes_[u].edges.remove(v);
+}
+
+void gp::detail::graph::add_root(node_id v) {
+    auto& n = nodes_[v];
+    if (n.roots++ == 0 && !n.in_root_list) {
+        n.in_root_list = true;
+        roots_.push_back(v);
+    }
+}
+
+void gp::detail::graph::remove_root(node_id v) {
+    nodes_[v].roots--;
+}
+
+void gp::detail::graph::mark() {
+    // drop the entries of nodes that are no longer roots while walking the list.
+    auto end = std::remove_if(roots_.begin(), roots_.end(),
+        [this](node_id v) -> bool {
+            auto& n = nodes_[v];
+            if (n.roots > 0 && n.in_use)
+                return false;
+            n.in_root_list = false;
+            return true;
+        }
+    );
+    roots_.erase(end, roots_.end());
 
-    return live;
+    for (auto root : roots_)
+        mark_from(root, false);
 }
 
-gp::detail::graph::adj_list& gp::detail::graph::get_or_create(void* v) {
-    auto iter = impl_.find(v);
-    if (iter != impl_.end()) {
-        return iter->second;
+void gp::detail::graph::mark_young() {
+    for (auto v : young_) {
+        if (nodes_[v].roots > 0)
+            mark_from(v, true);
     }
-    else {
-        return impl_.insert(
-            std::pair<void*, gp::detail::graph::adj_list>{ v, {} }
-        ).first->second;
+    for (auto u : remembered_) {
+        nodes_[u].edges.for_each(
+            [this](node_id v) {
+                mark_from(v, true);
+            }
+        );
     }
 }
 
-void gp::detail::graph::find_live_set(void* root, std::unordered_set<void*>& live) {
-    std::stack<void*> stack;
-    stack.push(root);
+bool gp::detail::graph::is_marked(node_id v) const {
+    return nodes_[v].marked;
+}
+
+void gp::detail::graph::share(node_id v) {
+    // everything reachable from a shared node is already shared.
+    std::vector<node_id> stack = { v };
     while (!stack.empty()) {
-        auto current = stack.top();
-        stack.pop();
+        auto current = stack.back();
+        stack.pop_back();
 
-        if (live.find(current) != live.end())
+        auto& n = nodes_[current];
+        if (n.shared)
             continue;
-        live.insert(current);
+        n.shared = true;
+
+        n.edges.for_each(
+            [&stack](node_id v) {
+                stack.push_back(v);
+            }
+        );
+    }
+}
+
+bool gp::detail::graph::is_shared(node_id v) const {
+    return nodes_[v].shared;
+}
+
+std::vector<gp::detail::node_id> gp::detail::graph::adopt(graph& other) {
+    std::vector<node_id> ids(other.nodes_.size());
+    for (node_id v = 0; v < static_cast<node_id>(other.nodes_.size()); ++v)
+        if (other.nodes_[v].in_use)
+            ids[v] = create_node();
+
+    for (node_id v = 0; v < static_cast<node_id>(other.nodes_.size()); ++v) {
+        auto& from = other.nodes_[v];
+        if (!from.in_use)
+            continue;
+        auto& to = nodes_[ids[v]];
+        to.edges = std::move(from.edges);
+        to.edges.relabel(ids);
+        to.shared = from.shared;
+        to.roots = from.roots;
+        if (to.roots > 0 && !to.in_root_list) {
+            to.in_root_list = true;
+            roots_.push_back(ids[v]);
+        }
+    }
+
+    other.nodes_.clear();
+    other.free_ids_.clear();
+    other.young_.clear();
+    other.remembered_.clear();
+    other.roots_.clear();
+    return ids;
+}
 
-        const auto& neighbors = impl_.at(current);
-        for (const auto& neighbor : neighbors) {
-            stack.push(neighbor);
+void gp::detail::graph::finish_collection(bool young_only) {
+    auto finish = [this](node_id v) {
+        auto& n = nodes_[v];
+        if (!n.in_use)
+            return;
+        if (n.marked) {
+            n.marked = false;
+            n.old = true;
+        } else {
+            free_node(v);
         }
+    };
+
+    if (young_only) {
+        for (auto v : young_)
+            finish(v);
+    } else {
+        for (node_id v = 0; v < static_cast<node_id>(nodes_.size()); ++v)
+            finish(v);
     }
-}
\ No newline at end of file
+
+    young_.clear();
+    for (auto u : remembered_)
+        nodes_[u].remembered = false;
+    remembered_.clear();
+}
+
+void gp::detail::graph::mark_from(node_id root, bool young_only) {
+    std::vector<node_id> stack = { root };
+    while (!stack.empty()) {
+        auto current = stack.back();
+        stack.pop_back();
+
+        auto& n = nodes_[current];
+        if (n.marked || (young_only && n.old))
+            continue;
+        n.marked = true;
+
+        n.edges.for_each(
+            [&stack](node_id v) {
+                stack.push_back(v);
+            }
+        );
+    }
+}
+
+void gp::detail::graph::free_node(node_id v) {
+    auto& n = nodes_[v];
+    n.edges.clear();
+    n.in_use = false;
+    free_ids_.push_back(v);
+}
@@ -9,25 +9,249 @@
 #include <set>
 #include <type_traits>
 #include <algorithm>
+#include <array>
+#include <iterator>
+#include <new>
+#include <cstdint>
 
 namespace gp {
 
     namespace detail {
 
+        using node_id = uint32_t;
+
+        // every pooled object is preceded in its slot by a header holding the dense
+        // index of its node in the reachability graph and the pool that owns it. The
+        // owner is kept here rather than in the pointers so that a pool can hand its
+        // objects over to another, see graph_pool::adopt.
+        struct alignas(16) object_header {
+            node_id id;
+            void* pool;
+        };
+
+        inline object_header* header_of(const void* obj) {
+            return reinterpret_cast<object_header*>(const_cast<char*>(static_cast<const char*>(obj)) - sizeof(object_header));
+        }
+
+        inline node_id id_of(const void* obj) {
+            return header_of(obj)->id;
+        }
+
+        // out-edges with counts, so that two graph_ptrs from u to v make one edge that 
+        // is only removed when both are released. A few edges are held inline; past 
+        // that they move to a hash table.
+        class edge_list {
+        public:
+
+            // returns true if u -> v was not already an edge.
+            bool insert(node_id v);
+            void remove(node_id v);
+            void clear();
+            // maps every target v to ids[v].
+            void relabel(const std::vector<node_id>& ids);
+
+            template<typename F>
+            void for_each(F func) const {
+                if (overflow_) {
+                    for (const auto& [v, count] : *overflow_)
+                        func(v);
+                } else {
+                    for (uint32_t i = 0; i < size_; ++i)
+                        func(inline_[i].v);
+                }
+            }
+
+        private:
+
+            struct edge {
+                node_id v;
+                uint32_t count;
+            };
+            static constexpr uint32_t k_inline_edges = 4;
+
+            uint32_t size_ = 0;
+            edge inline_[k_inline_edges];
+            std::unique_ptr<std::unordered_map<node_id, uint32_t>> overflow_;
+        };
+
         class graph {
         public:
 
-            void insert_edge(void* u, void* v);
-            void remove_edge(void* u, void* v);
-            std::unordered_set<void*> collect(const std::unordered_map<void*, int> roots);
+            node_id create_node();
+            void insert_edge(node_id u, node_id v);
+            void remove_edge(node_id u, node_id v);
+            void add_root(node_id v);
+            void remove_root(node_id v);
+
+            // marks the nodes reachable from the roots.
+            void mark();
+
+            // marks the nodes created since the last collection that are reachable 
+            // from young roots or from the remembered set of older nodes that have 
+            // been given edges to younger nodes.
+            void mark_young();
+
+            bool is_marked(node_id v) const;
+
+            // marks the nodes reachable from v as shared. Shared nodes stay shared
+            // until they are freed.
+            void share(node_id v);
+            bool is_shared(node_id v) const;
+
+            // moves the nodes of other into this graph as young nodes, keeping their
+            // edges and root counts, and leaves other empty. Returns the new id of each
+            // node of other, indexed by its old id.
+            std::vector<node_id> adopt(graph& other);
+
+            // frees the unmarked nodes, of only the young generation if young_only, and 
+            // promotes the survivors.
+            void finish_collection(bool young_only);
 
         private:
 
-            using adj_list = std::unordered_set<void*>;
-            adj_list& get_or_create(void* v);
-            void find_live_set(void* root, std::unordered_set<void*>& live);
+            struct node {
+                edge_list edges;
+                uint32_t roots = 0;
+                bool old = false;
+                bool marked = false;
+                bool remembered = false;
+                bool in_root_list = false;
+                bool in_use = true;
+                bool shared = false;
+            };
+
+            void mark_from(node_id root, bool young_only);
+            void free_node(node_id v);
+
+            std::vector<node> nodes_;
+            std::vector<node_id> free_ids_;
+            std::vector<node_id> young_;
+            std::vector<node_id> remembered_;
+            std::vector<node_id> roots_;
+        };
+
+        // objects of one type constructed in place in fixed size slabs, each behind 
+        // an object_header. Slots of destroyed objects are kept on a free list for 
+        // reuse. objects_ is in allocation order.
+        template<typename T>
+        class slab_pool {
+        public:
+
+            slab_pool() : free_list_(nullptr), next_slot_(k_slab_size) {}
+            slab_pool(const slab_pool&) = delete;
+            slab_pool& operator=(const slab_pool&) = delete;
+
+            ~slab_pool() {
+                destroy_all();
+            }
+
+            template<typename... Args>
+            T* make(node_id id, void* pool, Args&&... args) {
+                static_assert(alignof(T) <= alignof(object_header), "object_header must not pad the object");
+                slot* s = allocate();
+                s->header.id = id;
+                s->header.pool = pool;
+                T* obj = new(s->storage) T(std::forward<Args>(args)...);
+                objects_.push_back(obj);
+                return obj;
+            }
+
+            size_t size() const {
+                return objects_.size();
+            }
+
+            // destroys the objects allocated at or after the first_index'th 
+            // allocation for which is_dead is true.
+            template<typename F>
+            void sweep(size_t first_index, F is_dead) {
+                objects_.erase(
+                    std::remove_if(objects_.begin() + first_index, objects_.end(),
+                        [&](T* obj) -> bool {
+                            if (!is_dead(obj))
+                                return false;
+                            destroy(obj);
+                            return true;
+                        }
+                    ),
+                    objects_.end()
+                );
+            }
+
+            // destroys every object without freeing its slot. Objects read the headers of
+            // the objects they point to as they are destroyed, so a heap destroys all of
+            // its objects before any slab is released.
+            void destroy_all() {
+                for (T* obj : objects_)
+                    obj->~T();
+                objects_.clear();
+            }
+
+            // takes over the objects and slabs of other, giving each object the id ids[id]
+            // and the owner pool. The objects come last in allocation order.
+            void adopt(slab_pool& other, const std::vector<node_id>& ids, void* pool) {
+                for (T* obj : other.objects_) {
+                    auto* header = header_of(obj);
+                    header->id = ids[header->id];
+                    header->pool = pool;
+                }
+                objects_.insert(objects_.end(), other.objects_.begin(), other.objects_.end());
+
+                // the free and never used slots of other are reused here.
+                while (other.free_list_) {
+                    slot* s = other.free_list_;
+                    other.free_list_ = s->next;
+                    release(s);
+                }
+                if (!other.slabs_.empty()) {
+                    for (size_t i = other.next_slot_; i < k_slab_size; ++i)
+                        release(&other.slabs_.back()[i]);
+                }
+                std::move(other.slabs_.begin(), other.slabs_.end(), std::back_inserter(slabs_));
+
+                other.objects_.clear();
+                other.slabs_.clear();
+                other.next_slot_ = k_slab_size;
+            }
 
-            std::unordered_map<void*, adj_list> impl_;
+        private:
+
+            struct slot {
+                object_header header;
+                union {
+                    slot* next;
+                    alignas(T) unsigned char storage[sizeof(T)];
+                };
+            };
+
+            static constexpr size_t k_slab_size = 1024;
+
+            slot* allocate() {
+                if (free_list_) {
+                    slot* s = free_list_;
+                    free_list_ = s->next;
+                    return s;
+                }
+                if (next_slot_ == k_slab_size) {
+                    slabs_.emplace_back(new slot[k_slab_size]);
+                    next_slot_ = 0;
+                }
+                return &slabs_.back()[next_slot_++];
+            }
+
+            void destroy(T* obj) {
+                obj->~T();
+                release(reinterpret_cast<slot*>(reinterpret_cast<char*>(obj) - sizeof(object_header)));
+            }
+
+            void release(slot* s) {
+                s->next = free_list_;
+                free_list_ = s;
+            }
+
+            std::vector<T*> objects_;
+            std::vector<std::unique_ptr<slot[]>> slabs_;
+            slot* free_list_;
+            size_t next_slot_;
         };
 
     }
@@ -35,6 +259,11 @@ namespace gp {
     template<typename... Ts>
     class graph_pool {
 
+        // the object a graph_ptr points from.
+        struct edge_from {
+            void* obj;
+        };
+
     public:
 
         template<typename T>
@@ -62,15 +291,17 @@ namespace gp {
         template<typename T>
         class base_graph_ptr {
         public:
-            base_graph_ptr() : pool_(nullptr), v_(nullptr) {}
-            base_graph_ptr(graph_pool* p, T* v) : pool_(p), v_(v) {
+            base_graph_ptr() : v_(nullptr) {}
+            base_graph_ptr(T* v) : v_(v) {
             }
             T* operator->() const { return v_; }
             T& operator*()  const { return *v_; }
             T* get() const { return v_; }
             explicit operator bool() const { return v_; }
         protected:
-            graph_pool* pool_;
+            graph_pool* pool() const {
+                return v_ ? pool_of(v_) : nullptr;
+            }
             T* v_;
         };
 
@@ -88,13 +319,13 @@ namespace gp {
 
             template<typename A, typename B>
             graph_ptr(const A& u, const B& v) :
-                graph_ptr(u.pool_, u.v_, v.v_)
+                graph_ptr(edge_from{ u.v_ }, v.v_)
             {}
 
             graph_ptr(const graph_ptr& other) = delete;
 
             graph_ptr(graph_ptr&& other) noexcept :
-                u_{ other.u_ }, base_graph_ptr<T>{ other.pool_, other.v_ } {
+                u_{ other.u_ }, base_graph_ptr<T>{ other.v_ } {
                 other.wipe();
             }
             
@@ -108,7 +339,6 @@ namespace gp {
                 if (&other != this) {
                     release();
 
-                    this->pool_ = other.pool_;
                     u_ = other.u_;
                     this->v_ = other.v_;
 
@@ -134,31 +364,37 @@ namespace gp {
 
             void make_self_ptr() {
                 if constexpr (std::is_base_of< enable_self_graph_ptr<T>, T>::value) {
+                    if (!this->v_)
+                        return;
                     std::unique_ptr<graph_ptr<T>>& self_ptr = static_cast<enable_self_graph_ptr<T>*>(this->v_)->self_;
                     if (!self_ptr.get()) {
                         static_cast<enable_self_graph_ptr<T>*>(this->v_)->self_ = std::unique_ptr<graph_ptr<T>>(
-                            new graph_ptr<T>(this->pool_, this->v_, this->v_)
+                            new graph_ptr<T>(edge_from{ this->v_ }, this->v_)
                             );
                     }
                 }
             }
 
             void wipe() {
-                this->pool_ = nullptr;
                 u_ = nullptr;
                 this->v_ = nullptr;
             }
 
+            // the edge belongs to the pool of u, which owns v too.
             void release() {
-                if (this->pool_ && this->v_)
-                    this->pool_->graph_.remove_edge(u_, const_cast<non_const_type*>(this->v_));
+                if (!u_ || !this->v_)
+                    return;
+                auto* pool = pool_of(u_);
+                if (!pool->releasing_)
+                    pool->graph_.remove_edge(detail::id_of(u_), detail::id_of(this->v_));
             }
 
             void grab() {
-                this->pool_->graph_.insert_edge(u_, const_cast<non_const_type*>(this->v_));
+                if (u_ && this->v_)
+                    pool_of(u_)->graph_.insert_edge(detail::id_of(u_), detail::id_of(this->v_));
             }
 
-            graph_ptr(graph_pool* gp, void* u, T* v) : u_(u), base_graph_ptr<T>(gp, v) {
+            graph_ptr(edge_from u, T* v) : u_(u.obj), base_graph_ptr<T>(v) {
                 grab();
                 if (u_ != this->v_) {
                     make_self_ptr();
@@ -180,15 +416,15 @@ namespace gp {
             }
 
             graph_root_ptr(const graph_root_ptr& v) :
-                graph_root_ptr(v.pool_, v.v_) {
+                graph_root_ptr(v.v_) {
             }
 
             graph_root_ptr(const graph_ptr<T>& v) :
-                graph_root_ptr(v.pool_, v.v_) {
+                graph_root_ptr(v.v_) {
             }
 
             graph_root_ptr(graph_root_ptr&& other) noexcept :
-                base_graph_ptr<T>(other.pool_, other.v_) {
+                base_graph_ptr<T>(other.v_) {
                 other.wipe();
             }
 
@@ -200,7 +436,6 @@ namespace gp {
                 if (&other != this) {
                     release();
 
-                    this->pool_ = other.pool_;
                     this->v_ = other.v_;
 
                     grab();
@@ -212,7 +447,6 @@ namespace gp {
                 if (&other != this) {
                     release();
 
-                    this->pool_ = other.pool_;
                     this->v_ = other.v_;
 
                     other.wipe();
@@ -235,10 +469,12 @@ namespace gp {
 
             void make_self_ptr() {
                 if constexpr (std::is_base_of< enable_self_graph_ptr<T>, T>::value) {
+                    if (!this->v_)
+                        return;
                     std::unique_ptr<graph_ptr<T>>& self_ptr = static_cast<enable_self_graph_ptr<T>*>(this->v_)->self_;
                     if (!self_ptr.get()) {
                         static_cast<enable_self_graph_ptr<T>*>(this->v_)->self_ = std::unique_ptr<graph_ptr<T>>(
-                            new graph_ptr<T>(this->pool_, this->v_, this->v_)
+                            new graph_ptr<T>(edge_from{ this->v_ }, this->v_)
                             );
                     }
                 }
@@ -247,61 +483,79 @@ namespace gp {
             using non_const_type = std::remove_const_t<T>;
 
             void wipe() {
-                this->pool_ = nullptr;
                 this->v_ = nullptr;
             }
 
             void release() {
-                if (this->pool_ && this->v_)
-                    this->pool_->remove_root(const_cast<non_const_type*>(this->v_));
+                auto* pool = this->pool();
+                if (pool && !pool->releasing_)
+                    pool->remove_root(const_cast<non_const_type*>(this->v_));
             }
 
             void grab() {
-                this->pool_->add_root(const_cast<non_const_type*>(this->v_));
+                if (auto* pool = this->pool())
+                    pool->add_root(const_cast<non_const_type*>(this->v_));
             }
 
-            graph_root_ptr(graph_pool* gp, T* v) : base_graph_ptr<T>(gp, v) {
+            explicit graph_root_ptr(T* v) : base_graph_ptr<T>(v) {
                 grab();
                 make_self_ptr();
             }
         };
 
+        graph_pool() : releasing_(false) {}
+        graph_pool(const graph_pool&) = delete;
+        graph_pool& operator=(const graph_pool&) = delete;
+
+        // the whole heap is released at once; the objects' graph pointers do not 
+        // need to update the graph or the roots on the way out.
+        ~graph_pool() {
+            releasing_ = true;
+            apply_to_pools(pools_,
+                [](auto& pool, size_t) {
+                    pool.destroy_all();
+                }
+            );
+        }
+
         template<typename T, typename U, typename... Args>
         graph_ptr<T> make(graph_ptr<U> u, Args&&... args) {
-            auto& p = std::get<std::vector<std::unique_ptr<T>>>(pools_);
-            p.emplace_back(std::make_unique<T>(std::forward<Args>(args)...));
-            auto* new_ptr = p.back().get();
-            return graph_ptr(this, u.get(), new_ptr);
+            auto* new_ptr = std::get<detail::slab_pool<T>>(pools_).make(graph_.create_node(), this, std::forward<Args>(args)...);
+            return graph_ptr<T>(edge_from{ u.get() }, new_ptr);
         }
 
         template<typename T, typename... Args>
         graph_root_ptr<T> make_root(Args&&... args) {
-            auto& p = std::get<std::vector<std::unique_ptr<T>>>(pools_);
-            p.emplace_back(std::make_unique<T>(std::forward<Args>(args)...));
-            auto* new_ptr = p.back().get();
-            return graph_root_ptr(this, new_ptr);
+            auto* new_ptr = std::get<detail::slab_pool<T>>(pools_).make(graph_.create_node(), this, std::forward<Args>(args)...);
+            return graph_root_ptr<T>(new_ptr);
+        }
+
+        // moves every object of other into this pool without copying it; other is left
+        // empty. Pointers to the objects stay valid and from then on count against this
+        // pool's graph, so other must not be in use by another thread. The objects are 
+        // young here and unreachable ones go at the next collection.
+        void adopt(graph_pool& other) {
+            auto ids = graph_.adopt(other.graph_);
+            adopt_pools(other, ids);
+            other.old_counts_ = {};
         }
 
         void collect() {
-            auto live_set = graph_.collect(roots_);
-            apply_to_pools(pools_,
-                [&live_set](auto& pool) {
-                    pool.erase(
-                        std::remove_if(pool.begin(), pool.end(),
-                            [&live_set](const auto& un_ptr) -> bool {
-                                return live_set.find(un_ptr.get()) == live_set.end();
-                            }
-                        ),
-                        pool.end()
-                                );
-                }
-            );
+            graph_.mark();
+            sweep(false);
+        }
+
+        // a minor collection: only objects allocated since the last collection
+        // are considered, the rest are assumed live.
+        void collect_young() {
+            graph_.mark_young();
+            sweep(true);
         }
 
         size_t size() const {
             size_t sz = 0;
             apply_to_pools(pools_,
-                [&sz](const auto& p) {
+                [&sz](const auto& p, size_t) {
                     sz += p.size();
                 }
             );
@@ -310,39 +564,70 @@ namespace gp {
 
         template<typename T, typename U>
         static graph_root_ptr<T> const_pointer_cast(const graph_root_ptr<U>& p) {
-            return  graph_root_ptr<T>(p.pool_, const_cast<std::remove_const_t<U>*>(p.v_));
+            return  graph_root_ptr<T>(const_cast<std::remove_const_t<U>*>(p.v_));
+        }
+
+        // marks the objects reachable from p as shared.
+        template<typename T>
+        static void share(const graph_root_ptr<T>& p) {
+            if (p.v_)
+                pool_of(p.v_)->graph_.share(detail::id_of(p.v_));
+        }
+
+        template<typename T>
+        static bool is_shared(const graph_root_ptr<T>& p) {
+            return p.v_ && pool_of(p.v_)->graph_.is_shared(detail::id_of(p.v_));
         }
 
     private:
 
+        static graph_pool* pool_of(const void* obj) {
+            return static_cast<graph_pool*>(detail::header_of(obj)->pool);
+        }
+
+        template<size_t I = 0>
+        void adopt_pools(graph_pool& other, const std::vector<detail::node_id>& ids) {
+            std::get<I>(pools_).adopt(std::get<I>(other.pools_), ids, this);
+            if constexpr (I + 1 != sizeof...(Ts))
+                adopt_pools<I + 1>(other, ids);
+        }
+
         template<size_t I = 0, typename F, typename T>
         static void apply_to_pools(T& t, F func) {
             auto& pool = std::get<I>(t);
-            func(pool);
+            func(pool, I);
             if constexpr (I + 1 != std::tuple_size<T>::value)
                 apply_to_pools<I + 1>(t, func);
         }
 
+        // pools are in allocation order, so the objects allocated since the last
+        // collection are those past old_counts_.
+        void sweep(bool young_only) {
+            apply_to_pools(pools_,
+                [&](auto& pool, size_t i) {
+                    pool.sweep(young_only ? old_counts_[i] : 0,
+                        [this](auto* obj) -> bool {
+                            return !graph_.is_marked(detail::id_of(obj));
+                        }
+                    );
+                    old_counts_[i] = pool.size();
+                }
+            );
+            graph_.finish_collection(young_only);
+        }
+
         void add_root(void* root) {
-            auto it = roots_.find(root);
-            if (it != roots_.end()) {
-                it->second++;
-            }
-            else {
-                roots_[root] = 1;
-            }
+            graph_.add_root(detail::id_of(root));
         }
 
         void remove_root(void* root) {
-            auto it = roots_.find(root);
-            if (--it->second == 0) {
-                roots_.erase(it);
-            }
+            graph_.remove_root(detail::id_of(root));
         }
 
-        std::unordered_map<void*, int> roots_;
         detail::graph graph_;
-        std::tuple<std::vector<std::unique_ptr<Ts>>...> pools_;
+        bool releasing_;
+        std::tuple<detail::slab_pool<Ts>...> pools_;
+        std::array<size_t, sizeof...(Ts)> old_counts_ = {};
     };
 
 };
\ No newline at end of file
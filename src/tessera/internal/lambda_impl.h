@@ -3,6 +3,7 @@
 #include "function_def.h"
 #include "execution_state.h"
 #include "stack_machine.h"
+#include "bytecode.h"
 #include "tessera_impl.h"
 #include "gc_heap.h"
 
@@ -11,29 +12,30 @@ namespace tess {
         class lambda_impl : public tessera_impl, public enable_self_ptr<lambda_impl> {
             private:
                 unsigned int id_;
-                std::map<std::string, field_value> closure_;
                 std::vector<std::string> parameters_;
                 std::vector<std::string> dependencies_;
-                std::vector<stack_machine::item> body_;
+                std::vector<std::optional<field_value>> closure_; // parallel to dependencies_
+                std::vector<stack_machine::item> body_; // run by the reference interpreter
+                stack_machine::code_ref code_;
             public:
                 lambda_impl() : id_(0) {};
-                void initialize(gc_heap& a, const std::vector<std::string>& param, const std::vector<stack_machine::item>& bod, const std::vector<std::string>& deps);
+                void initialize(gc_heap& a, unsigned int id, const std::vector<std::string>& param, const std::vector<stack_machine::item>& bod, const std::vector<std::string>& deps);
+                void initialize(gc_heap& a, unsigned int id, const std::vector<std::string>& param, const stack_machine::code_ref& code, const std::vector<std::string>& deps);
 
                 void insert_field(const std::string& var, const value_& val);
+                void insert_field(int dependency, const value_& val);
                 value_ get_field(gc_heap& allocator, const std::string& field) const;
                 void set_id(unsigned int id);
+                // the lambda's code; lambdas made by the same function definition share it.
+                unsigned int id() const;
                 void clone_to(tess::gc_heap& allocator, std::unordered_map<obj_id, std::any>& orginal_to_clone, lambda_raw_ptr clone) const;
                 std::vector<std::string> unfulfilled_dependencies() const;
-                std::string serialize(serialization_state& state) const;
 
-                using const_closure_iter = std::map<std::string, field_value>::const_iterator;
-
-                const_closure_iter begin_closure() const;
-                const_closure_iter end_closure() const;
-                
+                const std::vector<std::optional<field_value>>& closure() const;
                 const std::vector<std::string>& parameters() const;
                 const std::vector<std::string>& dependencies() const;
                 const std::vector<stack_machine::item>& body() const;
+                const stack_machine::code_ref& code() const;
         };
     }
 }
\ No newline at end of file
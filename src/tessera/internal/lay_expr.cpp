@@ -11,15 +11,30 @@
 
 namespace {
    
-    std::optional<tess::error> compile_edge_mappings(const std::vector<std::tuple<tess::expr_ptr, tess::expr_ptr>>& mappings, tess::stack_machine::stack& stack)
+    std::optional<tess::error> compile_edge_mappings(const std::vector<std::tuple<tess::expr_ptr, tess::expr_ptr>>& mappings, tess::stack_machine::stack& stack, tess::stack_machine::scope& scope)
     {
         for (auto i = mappings.rbegin(); i != mappings.rend(); ++i) {
             auto [lhs, rhs] = *i;
-            rhs->compile(stack);
-            lhs->compile(stack);
+            rhs->compile(stack, scope);
+            lhs->compile(stack, scope);
         }
         return std::nullopt;
     }
+
+    // the layees are the placeholder variables $1, $2, ... of the frame nearest the lay
+    // that defines them.
+    std::vector<tess::stack_machine::variable> resolve_layees(const tess::stack_machine::scope& scope)
+    {
+        std::vector<tess::stack_machine::variable> layees;
+        auto first = scope.resolve("1");
+        for (int i = 1; ; ++i) {
+            auto var = scope.resolve(std::to_string(i));
+            if (!var.is_resolved() || var.depth() != first.depth())
+                break;
+            layees.push_back(var);
+        }
+        return layees;
+    }
 }
 
 tess::lay_expr::lay_expr(const std::vector<std::tuple<tess::expr_ptr, tess::expr_ptr>>& edge_mappings) : 
@@ -27,10 +42,10 @@ tess::lay_expr::lay_expr(const std::vector<std::tuple<tess::expr_ptr, tess::expr
 {
 }
 
-void tess::lay_expr::compile(stack_machine::stack& stack) const
+void tess::lay_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
-    stack.push(std::make_shared<tess::lay_op>(static_cast<int>(edge_mappings_.size())));
-    auto result = compile_edge_mappings(edge_mappings_, stack);
+    stack.push(std::make_shared<tess::lay_op>(static_cast<int>(edge_mappings_.size()), resolve_layees(scope)));
+    auto result = compile_edge_mappings(edge_mappings_, stack, scope);
 }
 
 void tess::lay_expr::get_dependencies( std::unordered_set<std::string>& dependencies ) const
@@ -70,7 +85,7 @@ tess::map_lay_expr::map_lay_expr(tess::expr_ptr mapping_cluster) :
 {
 }
 
-void tess::map_lay_expr::compile(tess::stack_machine::stack& stack) const
+void tess::map_lay_expr::compile(tess::stack_machine::stack& stack, tess::stack_machine::scope& scope) const
 {
 }
 
@@ -94,7 +109,7 @@ tess::partition_expr::partition_expr(expr_ptr cluster_expr) :
 {
 }
 
-void tess::partition_expr::compile(tess::stack_machine::stack& stack) const
+void tess::partition_expr::compile(tess::stack_machine::stack& stack, tess::stack_machine::scope& scope) const
 {
 }
 
@@ -17,7 +17,7 @@ namespace tess {
 	class lay_expr : public tess::expression {
 		public:
 			lay_expr(const std::vector<std::tuple<tess::expr_ptr, tess::expr_ptr>>& edge_mappings);
-			void compile(tess::stack_machine::stack& stack) const override;
+			void compile(tess::stack_machine::stack& stack, tess::stack_machine::scope& scope) const override;
 			std::string to_string() const override;
 			tess::expr_ptr simplify() const override;
 			void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
@@ -30,7 +30,7 @@ namespace tess {
 	class map_lay_expr : public tess::expression {
 	public:
 		map_lay_expr(expr_ptr mapping_cluster);
-		void compile(tess::stack_machine::stack& stack) const override;
+		void compile(tess::stack_machine::stack& stack, tess::stack_machine::scope& scope) const override;
 		std::string to_string() const override;
 		tess::expr_ptr simplify() const override;
 		void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
@@ -43,7 +43,7 @@ namespace tess {
 	class partition_expr : public tess::expression {
 	public:
 		partition_expr(expr_ptr cluster_expr);
-		void compile(tess::stack_machine::stack& stack) const override;
+		void compile(tess::stack_machine::stack& stack, tess::stack_machine::scope& scope) const override;
 		std::string to_string() const override;
 		tess::expr_ptr simplify() const override;
 		void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
@@ -0,0 +1,559 @@
+#include "memo_store.h"
+#include "tile_impl.h"
+#include "tile_patch_impl.h"
+#include "lambda_impl.h"
+#include "variant_util.h"
+#include "tessera/error.h"
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace {
+
+    enum value_tag : int64_t {
+        k_nil = 1,
+        k_false,
+        k_true,
+        k_number,
+        k_string,
+        k_tile,
+        k_patch,
+        k_cluster,
+        k_backref
+    };
+
+    enum token_tag : int64_t {
+        k_int_token = 1,
+        k_number_token,
+        k_string_token
+    };
+
+    // bumped whenever the layout of the file or of memo keys changes.
+    const std::string k_file_header = "tessera memos 1";
+
+    std::string number_format() {
+        return "number " + std::to_string(std::numeric_limits<tess::number>::digits);
+    }
+
+    class writer {
+    public:
+        void put(int64_t v) {
+            char bytes[sizeof(v)];
+            std::memcpy(bytes, &v, sizeof(v));
+            buffer_.append(bytes, sizeof(v));
+        }
+
+        void put(uint64_t v) {
+            put(static_cast<int64_t>(v));
+        }
+
+        // doubles as they are, software floats as text that reads back exactly.
+        void put(const tess::number& n) {
+            if constexpr (std::is_same_v<tess::number, double>) {
+                char bytes[sizeof(n)];
+                std::memcpy(bytes, &n, sizeof(n));
+                buffer_.append(bytes, sizeof(n));
+            } else {
+                std::stringstream ss;
+                ss.precision(std::numeric_limits<tess::number>::max_digits10);
+                ss << n;
+                put(ss.str());
+            }
+        }
+
+        void put(const std::string& s) {
+            put(static_cast<int64_t>(s.size()));
+            buffer_.append(s);
+        }
+
+        std::string& buffer() {
+            return buffer_;
+        }
+
+    private:
+        std::string buffer_;
+    };
+
+    // reads what a writer wrote, throwing if it runs off the end.
+    class reader {
+    public:
+        reader(const std::string& buffer, std::size_t pos = 0) : buffer_(buffer), pos_(pos) {}
+
+        int64_t get_int() {
+            int64_t v;
+            std::memcpy(&v, take(sizeof(v)), sizeof(v));
+            return v;
+        }
+
+        uint64_t get_uint() {
+            return static_cast<uint64_t>(get_int());
+        }
+
+        int get_count() {
+            auto n = get_int();
+            if (n < 0 || n > static_cast<int64_t>(buffer_.size()))
+                throw tess::error("corrupt memo file");
+            return static_cast<int>(n);
+        }
+
+        tess::number get_number() {
+            tess::number n;
+            if constexpr (std::is_same_v<tess::number, double>) {
+                std::memcpy(&n, take(sizeof(n)), sizeof(n));
+            } else {
+                std::stringstream ss(get_string());
+                ss >> n;
+            }
+            return n;
+        }
+
+        std::string get_string() {
+            auto n = get_count();
+            return std::string(take(n), n);
+        }
+
+        std::size_t pos() const {
+            return pos_;
+        }
+
+        bool at_end() const {
+            return pos_ == buffer_.size();
+        }
+
+    private:
+        const char* take(std::size_t n) {
+            if (n > buffer_.size() - pos_)
+                throw tess::error("corrupt memo file");
+            auto p = buffer_.data() + pos_;
+            pos_ += n;
+            return p;
+        }
+
+        const std::string& buffer_;
+        std::size_t pos_;
+    };
+
+    // writes a value as a graph: objects are numbered as they are written and written
+    // again as back references. Like memo keys, a tile in a patch is written as its
+    // patch and edges and vertices as their tile. A patch's tiles, and a tile's vertices
+    // and edges, are written before any fields so that fields can refer to them.
+    class value_writer {
+    public:
+        value_writer(writer& out) : out_(out) {}
+
+        template <typename V>
+        bool write(const V& v) {
+            return std::visit(
+                overloaded{
+                    [](const tess::field_ref_ptr&) -> bool {
+                        return false;
+                    },
+                    [this](tess::nil_val) -> bool {
+                        out_.put(k_nil);
+                        return true;
+                    },
+                    [this](const tess::number& n) -> bool {
+                        out_.put(k_number);
+                        out_.put(n);
+                        return true;
+                    },
+                    [this](const std::string& s) -> bool {
+                        out_.put(k_string);
+                        out_.put(s);
+                        return true;
+                    },
+                    [this](bool b) -> bool {
+                        out_.put(b ? k_true : k_false);
+                        return true;
+                    },
+                    [this](const auto& ptr) -> bool {
+                        return ptr && write_object(*ptr.get());
+                    }
+                },
+                v
+            );
+        }
+
+    private:
+        bool backref(const tess::tessera_impl& obj) {
+            int n = numbers_.find(obj.get_id());
+            if (n < 0)
+                return false;
+            out_.put(k_backref);
+            out_.put(static_cast<int64_t>(n));
+            return true;
+        }
+
+        void number(const tess::tessera_impl& obj) {
+            numbers_.visit(obj.get_id());
+        }
+
+        bool write_fields(const std::map<std::string, tess::field_value>& fields) {
+            out_.put(static_cast<int64_t>(fields.size()));
+            for (const auto& [name, val] : fields) {
+                out_.put(name);
+                if (!write(val))
+                    return false;
+            }
+            return true;
+        }
+
+        // patch is the tile's parent, if it has one, whose vertex table its vertices
+        // are read from directly.
+        void write_shape(const tess::detail::tile_impl& tile, const tess::detail::patch_impl* patch = nullptr) {
+            number(tile);
+            for (auto v = tile.begin_vertices(); v != tile.end_vertices(); ++v)
+                number(**v);
+            for (auto e = tile.begin_edges(); e != tile.end_edges(); ++e)
+                number(**e);
+
+            out_.put(static_cast<int64_t>(std::distance(tile.begin_vertices(), tile.end_vertices())));
+            for (auto v = tile.begin_vertices(); v != tile.end_vertices(); ++v) {
+                auto [x, y] = patch ? patch->get_vertex_location((*v)->location_index()) : (*v)->pos();
+                out_.put(x);
+                out_.put(y);
+                auto exact = patch ? patch->get_exact_vertex_location((*v)->location_index()) : (*v)->exact_pos();
+                out_.put(static_cast<int64_t>(exact ? exact->order() : 0));
+                if (exact) {
+                    const auto& coeffs = exact->coefficients();
+                    out_.put(static_cast<int64_t>(coeffs.size()));
+                    for (auto c : coeffs)
+                        out_.put(c);
+                }
+            }
+            // flipped edges run from their second vertex to their first.
+            int i = 0;
+            for (auto e = tile.begin_edges(); e != tile.end_edges(); ++e, ++i)
+                out_.put(static_cast<int64_t>((*e)->u()->get_id() != tile.vertex(i)->get_id()));
+        }
+
+        bool write_tile_fields(const tess::detail::tile_impl& tile) {
+            if (!write_fields(tile.fields()))
+                return false;
+            for (auto e = tile.begin_edges(); e != tile.end_edges(); ++e)
+                if (!write_fields((*e)->fields()))
+                    return false;
+            return true;
+        }
+
+        bool write_object(const tess::detail::lambda_impl&) {
+            return false;
+        }
+
+        bool write_object(const tess::detail::tile_impl& tile) {
+            if (backref(tile))
+                return true;
+            if (tile.has_parent()) {
+                auto patch = tile.parent();
+                return numbers_.find(patch->get_id()) < 0 &&
+                    write_object(*patch.get()) && backref(tile);
+            }
+            out_.put(k_tile);
+            write_shape(tile);
+            return write_tile_fields(tile);
+        }
+
+        bool write_object(const tess::detail::patch_impl& patch) {
+            if (backref(patch))
+                return true;
+            number(patch);
+            out_.put(k_patch);
+            out_.put(static_cast<int64_t>(patch.count()));
+            for (auto t = patch.begin_tiles(); t != patch.end_tiles(); ++t)
+                write_shape(**t, &patch);
+            if (!write_fields(patch.fields()))
+                return false;
+            for (auto t = patch.begin_tiles(); t != patch.end_tiles(); ++t)
+                if (!write_tile_fields(**t))
+                    return false;
+            return true;
+        }
+
+        bool write_object(const tess::detail::edge_impl& edge) {
+            if (backref(edge))
+                return true;
+            auto tile = edge.parent();
+            return tile && write_object(*tile.get()) && backref(edge);
+        }
+
+        bool write_object(const tess::detail::vertex_impl& vertex) {
+            if (backref(vertex))
+                return true;
+            auto tile = vertex.parent();
+            return tile && write_object(*tile.get()) && backref(vertex);
+        }
+
+        bool write_object(const tess::detail::cluster_impl& cluster) {
+            if (backref(cluster))
+                return true;
+            number(cluster);
+            out_.put(k_cluster);
+            out_.put(static_cast<int64_t>(std::distance(cluster.begin(), cluster.end())));
+            for (const auto& val : cluster)
+                if (!write(val))
+                    return false;
+            return true;
+        }
+
+        writer& out_;
+        tess::detail::visit_table numbers_;
+    };
+
+    class value_reader {
+    public:
+        value_reader(tess::gc_heap& a, reader& in) : a_(a), in_(in) {}
+
+        tess::value_ read() {
+            auto tag = in_.get_int();
+            switch (tag) {
+                case k_nil: return tess::nil_val();
+                case k_false: return false;
+                case k_true: return true;
+                case k_number: return in_.get_number();
+                case k_string: return in_.get_string();
+                case k_backref: {
+                    auto n = in_.get_int();
+                    if (n < 0 || n >= static_cast<int64_t>(objects_.size()))
+                        throw tess::error("corrupt memo file");
+                    return objects_[n];
+                }
+                case k_tile: {
+                    auto tile = read_shape();
+                    read_tile_fields(tile);
+                    return tess::make_value(tile);
+                }
+                case k_patch: {
+                    auto patch = a_.make_mutable<tess::const_patch_root_ptr>();
+                    objects_.push_back(tess::make_value(patch));
+                    std::vector<tess::tile_root_ptr> tiles(in_.get_count());
+                    for (auto& tile : tiles)
+                        tile = read_shape();
+                    patch->insert_tiles(tiles);
+                    read_fields([&](const std::string& name, const tess::value_& val) { patch->insert_field(name, val); });
+                    for (auto& tile : tiles)
+                        read_tile_fields(tile);
+                    return tess::make_value(patch);
+                }
+                case k_cluster: {
+                    auto cluster = a_.make_mutable<tess::const_cluster_root_ptr>(std::vector<tess::value_>{});
+                    objects_.push_back(tess::make_value(cluster));
+                    auto n = in_.get_count();
+                    for (int i = 0; i < n; ++i)
+                        cluster->push_value(read());
+                    return tess::make_value(cluster);
+                }
+                default:
+                    throw tess::error("corrupt memo file");
+            }
+        }
+
+    private:
+        tess::tile_root_ptr read_shape() {
+            auto n = in_.get_count();
+            std::vector<tess::point> pts;
+            std::vector<std::optional<tess::cyclotomic>> exact_pts;
+            for (int i = 0; i < n; ++i) {
+                auto x = in_.get_number();
+                auto y = in_.get_number();
+                pts.emplace_back(x, y);
+                auto order = static_cast<int>(in_.get_int());
+                if (order > 0) {
+                    std::vector<int64_t> coeffs(in_.get_count());
+                    for (auto& c : coeffs)
+                        c = in_.get_int();
+                    exact_pts.push_back(tess::cyclotomic::from_coefficients(order, std::move(coeffs)));
+                } else {
+                    exact_pts.push_back(std::nullopt);
+                }
+            }
+
+            auto tile = a_.make_mutable<tess::const_tile_root_ptr>(pts);
+            objects_.push_back(tess::make_value(tile));
+            for (int i = 0; i < n; ++i) {
+                tile->vertex(i)->set_location(pts[i], exact_pts[i]);
+                objects_.push_back(tess::make_value(tile->vertex(i)));
+            }
+            for (int i = 0; i < n; ++i)
+                objects_.push_back(tess::make_value(tile->edge(i)));
+            for (int i = 0; i < n; ++i)
+                if (in_.get_int())
+                    tile->edge(i)->flip();
+            return tile;
+        }
+
+        template <typename F>
+        void read_fields(F insert) {
+            auto n = in_.get_count();
+            for (int i = 0; i < n; ++i) {
+                auto name = in_.get_string();
+                insert(name, read());
+            }
+        }
+
+        void read_tile_fields(const tess::tile_root_ptr& tile) {
+            read_fields([&](const std::string& name, const tess::value_& val) { tile->insert_field(name, val); });
+            for (auto e = tile->begin_edges(); e != tile->end_edges(); ++e) {
+                auto edge = tess::to_root_ptr(*e);
+                read_fields([&](const std::string& name, const tess::value_& val) { edge->insert_field(name, val); });
+            }
+        }
+
+        tess::gc_heap& a_;
+        reader& in_;
+        std::vector<tess::value_> objects_;
+    };
+
+    void write_tokens(writer& out, const std::vector<tess::memo_token>& tokens) {
+        out.put(static_cast<int64_t>(tokens.size()));
+        for (const auto& token : tokens) {
+            std::visit(
+                overloaded{
+                    [&](int64_t v) {
+                        out.put(k_int_token);
+                        out.put(v);
+                    },
+                    [&](const tess::number& n) {
+                        out.put(k_number_token);
+                        out.put(n);
+                    },
+                    [&](const std::string& s) {
+                        out.put(k_string_token);
+                        out.put(s);
+                    }
+                },
+                token
+            );
+        }
+    }
+
+    std::vector<tess::memo_token> read_tokens(reader& in) {
+        std::vector<tess::memo_token> tokens(in.get_count());
+        for (auto& token : tokens) {
+            switch (in.get_int()) {
+                case k_int_token: token = in.get_int(); break;
+                case k_number_token: token = in.get_number(); break;
+                case k_string_token: token = in.get_string(); break;
+                default: throw tess::error("corrupt memo file");
+            }
+        }
+        return tokens;
+    }
+}
+
+tess::memo_store::memo_store(const std::string& path, uint64_t script) :
+    path_(path), script_(script), dirty_(false)
+{
+    try {
+        read();
+    } catch (const tess::error&) {
+        records_.clear();
+        others_.clear();
+    }
+}
+
+uint64_t tess::memo_store::fingerprint(const std::string& source)
+{
+    // FNV-1a, which unlike std::hash is the same from build to build.
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (unsigned char c : source) {
+        h ^= c;
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+// the file is a header followed by records, each the fingerprint of a script, the
+// tokens of a memo key and the size and bytes of the value stored under it.
+void tess::memo_store::read()
+{
+    std::ifstream file(path_, std::ios::binary);
+    if (!file)
+        return;
+    std::string contents{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+    reader in(contents);
+    if (in.get_string() != k_file_header || in.get_string() != number_format())
+        return;
+    while (!in.at_end()) {
+        auto start = in.pos();
+        auto script = in.get_uint();
+        auto tokens = read_tokens(in);
+        auto value = in.get_string();
+        if (script == script_) {
+            auto hash = hash_tokens(tokens);
+            records_[hash] = { std::move(tokens), std::move(value) };
+        } else {
+            others_.append(contents, start, in.pos() - start);
+        }
+    }
+}
+
+std::optional<tess::value_> tess::memo_store::load(gc_heap& a, const memo_key& key) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = records_.find(key.hash);
+    if (iter == records_.end() || iter->second.tokens != key.tokens)
+        return std::nullopt;
+
+    try {
+        reader in(iter->second.value);
+        return value_reader(a, in).read();
+    } catch (const tess::error&) {
+        return std::nullopt;
+    } catch (const cyclotomic_overflow&) {
+        return std::nullopt;
+    }
+}
+
+bool tess::memo_store::store(const memo_key& key, const value_& v)
+{
+    writer out;
+    if (key.empty() || !value_writer(out).write(v))
+        return false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    records_[key.hash] = { key.tokens, std::move(out.buffer()) };
+    dirty_ = true;
+    return true;
+}
+
+void tess::memo_store::save()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!dirty_)
+        return;
+
+    writer out;
+    out.put(k_file_header);
+    out.put(number_format());
+    out.buffer().append(others_);
+    for (const auto& [hash, rec] : records_) {
+        out.put(script_);
+        write_tokens(out, rec.tokens);
+        out.put(rec.value);
+    }
+
+    // written beside the old file and renamed over it, so that a reader never sees
+    // half a file.
+    auto temp = path_ + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file)
+            throw tess::error("unable to write memo file: " + path_);
+        file.write(out.buffer().data(), static_cast<std::streamsize>(out.buffer().size()));
+        if (!file)
+            throw tess::error("unable to write memo file: " + path_);
+    }
+    if (std::rename(temp.c_str(), path_.c_str()) != 0)
+        throw tess::error("unable to write memo file: " + path_);
+    dirty_ = false;
+}
+
+std::size_t tess::memo_store::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return records_.size();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "memoization.h"
+#include "value.h"
+#include <string>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include <cstdint>
+#include <mutex>
+
+namespace tess {
+
+    class gc_heap;
+
+    // memoized results kept in a file from run to run. The file can hold the results of
+    // any number of scripts; a store reads and writes those of the script it was opened
+    // for, named by a fingerprint of its source, and passes the rest through as is.
+    // Results that hold lambdas or field references are not kept. A store can be shared
+    // by executions running at the same time.
+    class memo_store
+    {
+    public:
+        // an unreadable or missing file is treated as empty.
+        memo_store(const std::string& path, uint64_t script);
+        static uint64_t fingerprint(const std::string& source);
+
+        // the result stored under key, made in a, if any.
+        std::optional<value_> load(gc_heap& a, const memo_key& key) const;
+        // false if v can not be written to the file.
+        bool store(const memo_key& key, const value_& v);
+        // writes the file if anything was stored since it was read.
+        void save();
+        std::size_t size() const;
+
+    private:
+        struct record {
+            std::vector<memo_token> tokens;
+            std::string value;
+        };
+
+        void read();
+
+        std::string path_;
+        uint64_t script_;
+        std::unordered_map<memo_hash, record, memo_hash_hasher> records_;
+        std::string others_;
+        bool dirty_;
+        mutable std::mutex mutex_;
+    };
+}
@@ -0,0 +1,434 @@
+#include "memoization.h"
+#include "memo_store.h"
+#include "stack_machine.h"
+#include "lambda_impl.h"
+#include "tile_impl.h"
+#include "tile_patch_impl.h"
+#include "variant_util.h"
+#include "boost/functional/hash.hpp"
+#include <functional>
+#include <iterator>
+
+namespace {
+
+    enum token_tag : int64_t {
+        k_nil = 1,
+        k_false,
+        k_true,
+        k_number,
+        k_string,
+        k_lambda,
+        k_tile,
+        k_patch,
+        k_cluster,
+        k_unset,
+        k_backref
+    };
+
+    uint64_t mix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ull;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebull;
+        x ^= x >> 31;
+        return x;
+    }
+
+    // two independently seeded 64-bit lanes folded over the tokens.
+    class hasher {
+    public:
+        void add(int64_t v) {
+            add_bits(static_cast<uint64_t>(v));
+        }
+
+        void add(const tess::number& n) {
+            add_bits(boost::hash_value(n));
+        }
+
+        void add(const std::string& s) {
+            add_bits(std::hash<std::string>()(s));
+        }
+
+        tess::memo_hash hash() const {
+            return { mix(lo_ ^ count_), mix(hi_ + count_) };
+        }
+
+    private:
+        void add_bits(uint64_t v) {
+            lo_ = mix(lo_ ^ v);
+            hi_ = mix((hi_ + v) * 0xff51afd7ed558ccdull);
+            ++count_;
+        }
+
+        uint64_t lo_ = 0x9e3779b97f4a7c15ull;
+        uint64_t hi_ = 0xc2b2ae3d27d4eb4full;
+        uint64_t count_ = 0;
+    };
+
+    class recorder {
+    public:
+        recorder(std::vector<tess::memo_token>& tokens) : tokens_(tokens) {}
+
+        void add(int64_t v) {
+            tokens_.emplace_back(v);
+        }
+
+        void add(const tess::number& n) {
+            tokens_.emplace_back(n);
+        }
+
+        void add(const std::string& s) {
+            tokens_.emplace_back(s);
+        }
+
+    private:
+        std::vector<tess::memo_token>& tokens_;
+    };
+
+    // checks the walk against recorded tokens as it goes.
+    class comparer {
+    public:
+        comparer(const std::vector<tess::memo_token>& tokens) : tokens_(tokens), i_(0), equal_(true) {}
+
+        void add(int64_t v) {
+            compare(v);
+        }
+
+        void add(const tess::number& n) {
+            compare(n);
+        }
+
+        void add(const std::string& s) {
+            compare(s);
+        }
+
+        bool equal() const {
+            return equal_ && i_ == tokens_.size();
+        }
+
+    private:
+        template <typename T>
+        void compare(const T& v) {
+            if (!equal_ || i_ == tokens_.size()) {
+                equal_ = false;
+                return;
+            }
+            auto token = std::get_if<T>(&tokens_[i_++]);
+            equal_ = token && *token == v;
+        }
+
+        const std::vector<tess::memo_token>& tokens_;
+        std::size_t i_;
+        bool equal_;
+    };
+
+    // walks a call, feeding its tokens to a sink. Tiles are written as their fields,
+    // vertex positions and edge fields; a tile in a patch is written as its patch and
+    // edges and vertices as their tile, so that their neighbours are part of the key.
+    // Field references can not be part of a key.
+    template <typename Sink>
+    class call_walker {
+    public:
+        call_walker(tess::detail::visit_table& visits, Sink& sink) : visits_(visits), sink_(sink) {}
+
+        bool walk(const tess::const_lambda_root_ptr& func, const tess::stack_machine::args_view& args) {
+            visits_.clear();
+            if (!walk_object(*func))
+                return false;
+            add(args.size());
+            for (const auto& arg : args)
+                if (!walk(arg))
+                    return false;
+            return true;
+        }
+
+    private:
+        template <typename T>
+        void add(T v) {
+            sink_.add(static_cast<int64_t>(v));
+        }
+
+        // writes a back reference if obj was already walked.
+        bool backref(const tess::tessera_impl& obj) {
+            int n = visits_.find(obj.get_id());
+            if (n < 0)
+                return false;
+            add(k_backref);
+            add(n);
+            return true;
+        }
+
+        template <typename V>
+        bool walk(const V& v) {
+            return std::visit(
+                overloaded{
+                    [](const tess::field_ref_ptr&) -> bool {
+                        return false;
+                    },
+                    [this](tess::nil_val) -> bool {
+                        add(k_nil);
+                        return true;
+                    },
+                    [this](const tess::number& n) -> bool {
+                        add(k_number);
+                        sink_.add(n);
+                        return true;
+                    },
+                    [this](const std::string& s) -> bool {
+                        add(k_string);
+                        sink_.add(s);
+                        return true;
+                    },
+                    [this](bool b) -> bool {
+                        add(b ? k_true : k_false);
+                        return true;
+                    },
+                    [this](const auto& ptr) -> bool {
+                        return ptr && walk_object(*ptr.get());
+                    }
+                },
+                v
+            );
+        }
+
+        bool walk_fields(const std::map<std::string, tess::field_value>& fields) {
+            add(fields.size());
+            for (const auto& [name, val] : fields) {
+                sink_.add(name);
+                if (!walk(val))
+                    return false;
+            }
+            return true;
+        }
+
+        bool walk_object(const tess::detail::lambda_impl& lambda) {
+            if (backref(lambda))
+                return true;
+            visits_.visit(lambda.get_id());
+
+            add(k_lambda);
+            add(lambda.id());
+            const auto& closure = lambda.closure();
+            add(closure.size());
+            for (const auto& val : closure) {
+                if (!val.has_value())
+                    add(k_unset);
+                else if (!walk(*val))
+                    return false;
+            }
+            return true;
+        }
+
+        bool walk_object(const tess::detail::tile_impl& tile) {
+            if (backref(tile))
+                return true;
+            if (tile.has_parent()) {
+                auto patch = tile.parent();
+                if (visits_.find(patch->get_id()) < 0)
+                    return walk_object(*patch.get()) && backref(tile);
+            }
+
+            visits_.visit(tile.get_id());
+            for (auto v = tile.begin_vertices(); v != tile.end_vertices(); ++v)
+                visits_.visit((*v)->get_id());
+            for (auto e = tile.begin_edges(); e != tile.end_edges(); ++e)
+                visits_.visit((*e)->get_id());
+
+            add(k_tile);
+            if (!walk_fields(tile.fields()))
+                return false;
+            add(std::distance(tile.begin_vertices(), tile.end_vertices()));
+            for (auto v = tile.begin_vertices(); v != tile.end_vertices(); ++v) {
+                auto [x, y] = (*v)->pos();
+                sink_.add(x);
+                sink_.add(y);
+            }
+            add(std::distance(tile.begin_edges(), tile.end_edges()));
+            for (auto e = tile.begin_edges(); e != tile.end_edges(); ++e)
+                if (!walk_fields((*e)->fields()))
+                    return false;
+            return true;
+        }
+
+        bool walk_object(const tess::detail::patch_impl& patch) {
+            if (backref(patch))
+                return true;
+            visits_.visit(patch.get_id());
+
+            add(k_patch);
+            if (!walk_fields(patch.fields()))
+                return false;
+            add(patch.count());
+            for (auto t = patch.begin_tiles(); t != patch.end_tiles(); ++t)
+                if (!walk_object(**t))
+                    return false;
+            return true;
+        }
+
+        bool walk_object(const tess::detail::edge_impl& edge) {
+            if (backref(edge))
+                return true;
+            auto tile = edge.parent();
+            return tile && walk_object(*tile.get()) && backref(edge);
+        }
+
+        bool walk_object(const tess::detail::vertex_impl& vertex) {
+            if (backref(vertex))
+                return true;
+            auto tile = vertex.parent();
+            return tile && walk_object(*tile.get()) && backref(vertex);
+        }
+
+        bool walk_object(const tess::detail::cluster_impl& cluster) {
+            if (backref(cluster))
+                return true;
+            visits_.visit(cluster.get_id());
+
+            add(k_cluster);
+            add(std::distance(cluster.begin(), cluster.end()));
+            for (const auto& val : cluster)
+                if (!walk(val))
+                    return false;
+            return true;
+        }
+
+        tess::detail::visit_table& visits_;
+        Sink& sink_;
+    };
+
+    template <typename Sink>
+    bool walk_call(tess::detail::visit_table& visits, Sink& sink, const tess::const_lambda_root_ptr& func, const tess::stack_machine::args_view& args) {
+        return call_walker<Sink>(visits, sink).walk(func, args);
+    }
+}
+
+bool tess::operator==(const memo_hash& lhs, const memo_hash& rhs)
+{
+    return lhs.lo == rhs.lo && lhs.hi == rhs.hi;
+}
+
+tess::memo_hash tess::hash_tokens(const std::vector<memo_token>& tokens)
+{
+    hasher h;
+    for (const auto& token : tokens)
+        std::visit([&h](const auto& v) { h.add(v); }, token);
+    return h.hash();
+}
+
+void tess::detail::visit_table::clear()
+{
+    for (int slot : used_)
+        slots_[slot] = { 0, -1 };
+    used_.clear();
+}
+
+int tess::detail::visit_table::find(obj_id obj) const
+{
+    if (slots_.empty())
+        return -1;
+    auto mask = slots_.size() - 1;
+    for (auto i = mix(obj) & mask; slots_[i].first != 0; i = (i + 1) & mask)
+        if (slots_[i].first == obj)
+            return slots_[i].second;
+    return -1;
+}
+
+int tess::detail::visit_table::visit(obj_id obj)
+{
+    if (2 * (used_.size() + 1) > slots_.size())
+        grow();
+    auto mask = slots_.size() - 1;
+    auto i = mix(obj) & mask;
+    for (; slots_[i].first != 0; i = (i + 1) & mask)
+        if (slots_[i].first == obj)
+            return slots_[i].second;
+    slots_[i] = { obj, static_cast<int>(used_.size()) };
+    used_.push_back(static_cast<int>(i));
+    return -1;
+}
+
+void tess::detail::visit_table::grow()
+{
+    std::vector<std::pair<obj_id, int>> visited(used_.size());
+    for (int slot : used_)
+        visited[slots_[slot].second] = slots_[slot];
+
+    slots_.assign(slots_.empty() ? 64 : 2 * slots_.size(), { 0, -1 });
+    used_.clear();
+    for (const auto& v : visited)
+        visit(v.first);
+}
+
+const tess::value_* tess::memoization_tbl::find(const const_lambda_root_ptr& func, const stack_machine::args_view& args, memo_key& key)
+{
+    key.tokens.clear();
+
+    hasher h;
+    if (!walk_call(visits_, h, func, args))
+        return nullptr;
+    key.hash = h.hash();
+
+    auto iter = tbl_.find(key.hash);
+    if (iter != tbl_.end()) {
+        comparer c(iter->second.tokens);
+        if (walk_call(visits_, c, func, args) && c.equal()) {
+            ++stats_.hits;
+            return &iter->second.value;
+        }
+    }
+
+    recorder r(key.tokens);
+    walk_call(visits_, r, func, args);
+
+    if (store_) {
+        auto val = store_->load(*allocator_, key);
+        if (val) {
+            ++stats_.hits;
+            ++stats_.loaded;
+            tess::share(*val);
+            auto& e = tbl_.insert_or_assign(key.hash, entry{ key.tokens, *val, true }).first->second;
+            return &e.value;
+        }
+    }
+
+    ++stats_.misses;
+    return nullptr;
+}
+
+void tess::memoization_tbl::insert(memo_key key, const value_& v)
+{
+    if (key.empty())
+        return;
+    // hits hand out v itself, so it must not change under the table.
+    tess::share(v);
+    tbl_.insert_or_assign(key.hash, entry{ std::move(key.tokens), v, false });
+}
+
+std::size_t tess::memoization_tbl::size() const
+{
+    return tbl_.size();
+}
+
+void tess::memoization_tbl::attach(std::shared_ptr<memo_store> store, gc_heap& a)
+{
+    store_ = std::move(store);
+    allocator_ = &a;
+}
+
+void tess::memoization_tbl::save()
+{
+    if (!store_)
+        return;
+    for (auto& [hash, e] : tbl_) {
+        if (e.stored)
+            continue;
+        store_->store({ hash, e.tokens }, e.value);
+        e.stored = true;
+    }
+    store_->save();
+}
+
+const tess::memo_stats& tess::memoization_tbl::stats() const
+{
+    return stats_;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "value.h"
+#include "tessera/script.h"
+#include <vector>
+#include <string>
+#include <variant>
+#include <unordered_map>
+#include <utility>
+#include <memory>
+#include <cstdint>
+
+namespace tess {
+
+    class gc_heap;
+    class memo_store;
+
+    namespace stack_machine {
+        template <typename T>
+        class operand_view;
+    }
+
+    struct memo_hash {
+        uint64_t lo;
+        uint64_t hi;
+    };
+
+    bool operator==(const memo_hash& lhs, const memo_hash& rhs);
+
+    struct memo_hash_hasher {
+        std::size_t operator()(const memo_hash& h) const {
+            return static_cast<std::size_t>(h.lo);
+        }
+    };
+
+    using memo_token = std::variant<int64_t, number, std::string>;
+
+    // a call to a lambda flattened into a token stream: the lambda's id and closure
+    // followed by the arguments, walked structurally with objects seen earlier in the
+    // walk written as back references. Empty if the call can not be memoized.
+    struct memo_key {
+        memo_hash hash = { 0, 0 };
+        std::vector<memo_token> tokens;
+
+        bool empty() const {
+            return tokens.empty();
+        }
+    };
+
+    // the hash find gives a call, computed from the tokens recorded for it.
+    memo_hash hash_tokens(const std::vector<memo_token>& tokens);
+
+    namespace detail {
+
+        // the objects a walk has been through, numbered in the order it reached them.
+        // Open addressing over storage kept from walk to walk.
+        class visit_table {
+        public:
+            void clear();
+            // the number of obj, or -1 if it has not been visited.
+            int find(obj_id obj) const;
+            // the number of obj if it was already visited, otherwise numbers it and returns -1.
+            int visit(obj_id obj);
+        private:
+            void grow();
+            std::vector<std::pair<obj_id, int>> slots_;
+            std::vector<int> used_;
+        };
+
+    }
+
+    class memoization_tbl
+    {
+    public:
+        // the memoized result of calling func on args, or nullptr. On a miss key is set
+        // to what the result should be inserted under; hits do not allocate.
+        const value_* find(const const_lambda_root_ptr& func, const stack_machine::operand_view<value_>& args, memo_key& key);
+        void insert(memo_key key, const value_& v);
+        std::size_t size() const;
+
+        // calls missing from the table are looked up in store, their results made in a,
+        // and save writes what the table has memoized since to it.
+        void attach(std::shared_ptr<memo_store> store, gc_heap& a);
+        void save();
+
+        const memo_stats& stats() const;
+    private:
+        struct entry {
+            std::vector<memo_token> tokens;
+            value_ value;
+            bool stored;
+        };
+
+        std::unordered_map<memo_hash, entry, memo_hash_hasher> tbl_;
+        detail::visit_table visits_;
+        std::shared_ptr<memo_store> store_;
+        gc_heap* allocator_ = nullptr;
+        memo_stats stats_;
+    };
+}
@@ -1,10 +1,26 @@
 #include "number.h"
 #include <boost/math/constants/constants.hpp>
 
-namespace bm = boost::multiprecision;
+#include <cmath>
 
 namespace {
 
+	// dispatch to <cmath> for built-in floating point or, through ADL, to 
+	// boost::multiprecision when tess::number is a quad float.
+	namespace math {
+
+		tess::number pow(const tess::number& base, const tess::number& ex) { using std::pow; return pow(base, ex); }
+		tess::number acos(const tess::number& arg) { using std::acos; return acos(arg); }
+		tess::number asin(const tess::number& arg) { using std::asin; return asin(arg); }
+		tess::number atan(const tess::number& arg) { using std::atan; return atan(arg); }
+		tess::number cos(const tess::number& arg) { using std::cos; return cos(arg); }
+		tess::number sin(const tess::number& arg) { using std::sin; return sin(arg); }
+		tess::number sqrt(const tess::number& arg) { using std::sqrt; return sqrt(arg); }
+		tess::number tan(const tess::number& arg) { using std::tan; return tan(arg); }
+		tess::number abs(const tess::number& arg) { using std::abs; return abs(arg); }
+
+	}
+
 	using vec = Eigen::Matrix<tess::number, 3, 1>;
 
 	tess::point operator-(const tess::point& a) {
@@ -62,7 +78,7 @@ namespace {
 		auto [x2, y2] = v;
 		auto x_diff = x2 - x1;
 		auto y_diff = y2 - y1;
-		return bm::sqrt(x_diff * x_diff + y_diff * y_diff);
+		return math::sqrt(x_diff * x_diff + y_diff * y_diff);
 	}
 
 	tess::matrix to_line_seg(const tess::line_segment& line_segment)
@@ -113,7 +129,7 @@ namespace {
 
 bool tess::equals(const number& a, number& b)
 {
-	return bm::abs(a - b) < std::numeric_limits<tess::number>::epsilon();
+	return math::abs(a - b) < std::numeric_limits<tess::number>::epsilon();
 }
 
 bool tess::equals(const point& a, const point& b)
@@ -161,7 +177,7 @@ tess::number tess::distance(point p1, point p2)
 	auto diff_x = x2 - x1;
 	auto diff_y = y2 - y1;
 
-	return bm::sqrt(diff_x * diff_x + diff_y * diff_y);
+	return math::sqrt(diff_x * diff_x + diff_y * diff_y);
 }
 
 tess::point tess::apply_matrix(const matrix& mat, const point& pt)
@@ -191,35 +207,35 @@ tess::matrix tess::flip_matrix()
 }
 
 tess::number tess::pow(number base, number ex) {
-	return bm::pow(base, ex);
+	return math::pow(base, ex);
 }
 
 tess::number tess::acos(number arg) {
-	return bm::acos(arg);
+	return math::acos(arg);
 }
 
 tess::number tess::asin(number arg) {
-	return bm::asin(arg);
+	return math::asin(arg);
 }
 
 tess::number tess::atan(number arg) {
-	return bm::atan(arg);
+	return math::atan(arg);
 }
 
 tess::number tess::cos(number arg) {
-	return bm::cos(arg);
+	return math::cos(arg);
 }
 
 tess::number tess::sin(number arg) {
-	return bm::sin(arg);
+	return math::sin(arg);
 }
 
 tess::number tess::sqrt(number arg) {
-	return bm::sqrt(arg);
+	return math::sqrt(arg);
 }
 
 tess::number tess::tan(number arg) {
-	return bm::tan(arg);
+	return math::tan(arg);
 }
 
 tess::number tess::pi()
@@ -239,6 +255,6 @@ tess::number tess::root_2()
 
 tess::number tess::abs(number arg)
 {
-	return bm::abs(arg);
+	return math::abs(arg);
 }
 
@@ -1,13 +1,21 @@
 #pragma once
 
+#ifdef TESSERA_QUAD_PRECISION
 #include <boost/multiprecision/cpp_bin_float.hpp>
 #include <boost/multiprecision/eigen.hpp>
+#endif
 #include <Eigen/Dense>
 #include <tuple>
 
 namespace tess {
 
+	// hardware doubles unless the build asks for software quad floats, 
+	// see the TESSERA_QUAD_PRECISION option in CMakeLists.txt.
+#ifdef TESSERA_QUAD_PRECISION
 	using number = boost::multiprecision::cpp_bin_float_quad;
+#else
+	using number = double;
+#endif
 	using matrix = Eigen::Matrix<number, 3, 3>;
 	using point = std::tuple<number,number>;
 	using line_segment = std::tuple<point, point>;
@@ -8,10 +8,9 @@ tess::var_expr::var_expr(const std::string& var) :
 {
 }
 
-void tess::var_expr::compile(stack_machine::stack& stack) const
+void tess::var_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
-    stack.push(std::make_shared<get_var>());
-    stack.push(stack_machine::variable(var_));
+    stack.push(std::make_shared<get_var>(scope.resolve(var_)));
 }
 
 std::string tess::var_expr::to_string() const
@@ -37,10 +36,9 @@ tess::placeholder_expr::placeholder_expr(int placeholder) :
 }
 
 
-void tess::placeholder_expr::compile(stack_machine::stack& stack) const
+void tess::placeholder_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
-    stack.push(std::make_shared<get_var>());
-    stack.push(stack_machine::variable(placeholder_));
+    stack.push(std::make_shared<get_var>(scope.resolve(std::to_string(placeholder_))));
 }
 
 void tess::placeholder_expr::get_dependencies(std::unordered_set<std::string>& dependencies) const
@@ -65,11 +63,11 @@ std::string tess::array_item_expr::to_string() const
     return "( get_ary_item " + ary_->to_string() + " " + index_->to_string() + " )";
 }
 
-void tess::array_item_expr::compile(stack_machine::stack& stack) const
+void tess::array_item_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
     stack.push(std::make_shared<get_ary_item_op>());
-    ary_->compile(stack);
-    index_->compile(stack);
+    ary_->compile(stack, scope);
+    index_->compile(stack, scope);
 }
 
 void tess::array_item_expr::get_dependencies(std::unordered_set<std::string>& dependencies) const
@@ -94,14 +92,14 @@ tess::func_call_expr::func_call_expr(expr_ptr func, const std::vector<expr_ptr>&
 {
 }
 
-void tess::func_call_expr::compile(stack_machine::stack& stack) const
+void tess::func_call_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
     int n = static_cast<int>(args_.size());
     stack.push(std::make_shared<pop_eval_context>());
     stack.push(std::make_shared<call_func>(n));
     stack.push(std::make_shared<push_eval_context>());
-    func_->compile(stack);
-    stack.compile_and_push(args_);
+    func_->compile(stack, scope);
+    stack.compile_and_push(args_, scope);
 }
 
 std::string tess::func_call_expr::to_string() const
@@ -167,10 +165,10 @@ std::string tess::obj_field_expr::get_field() const
     return field_;
 }
 
-void tess::obj_field_expr::compile(stack_machine::stack& stack) const
+void tess::obj_field_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
     stack.push(std::make_shared<get_field_op>(field_, is_ref_));
-    obj_->compile(stack);
+    obj_->compile(stack, scope);
 }
 
 void tess::obj_field_expr::get_dependencies(std::unordered_set<std::string>& dependencies) const
@@ -15,7 +15,7 @@ namespace tess {
         std::string var_;
     public:
         var_expr(const std::string& var);
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         std::string to_string() const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
         expr_ptr simplify() const override;
@@ -27,7 +27,7 @@ namespace tess {
         int placeholder_;
     public:
         placeholder_expr(int  placeholder);
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
         expr_ptr simplify() const override;
         std::string to_string() const override { return "$(" + std::to_string(placeholder_) +")"; }
@@ -41,7 +41,7 @@ namespace tess {
     public:
         array_item_expr(expr_ptr ary, expr_ptr index);
         std::string to_string() const override;
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
         expr_ptr simplify() const override;
     };
@@ -54,7 +54,7 @@ namespace tess {
     public:
         func_call_expr(expr_ptr func_, const std::vector<expr_ptr>& args);
         std::string to_string() const override;
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
         expr_ptr simplify() const override;
     };
@@ -70,7 +70,7 @@ namespace tess {
         std::string to_string() const override;
         expr_ptr get_object() const;
         std::string get_field() const;
-        void compile(stack_machine::stack& stack) const override;
+        void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
         void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
         expr_ptr simplify() const override;
     };
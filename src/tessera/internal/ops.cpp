@@ -10,6 +10,7 @@
 #include "field_ref.h"
 #include "tile_patch_impl.h"
 #include "tessera/tile_patch.h"
+#include "bytecode.h"
 #include <sstream>
 
 namespace {
@@ -24,18 +25,32 @@ namespace {
             return tile->parent();
     }
 
-    void apply_edge_matrix(const edge_parent_type& ep, const tess::matrix& mat) {
-        return std::visit([&mat](auto ptr) { ptr->apply(mat); }, ep);
+    using edge_transform = std::tuple<tess::matrix, std::optional<tess::exact_transform>>;
+
+    void apply_edge_matrix(const edge_parent_type& ep, const edge_transform& transform) {
+        const auto& [mat, exact] = transform;
+        return std::visit([&](auto ptr) { ptr->apply(mat, exact); }, ep);
     }
 
-    tess::matrix edge_to_edge_matrix(const tess::edge::impl_type& e1, const tess::edge::impl_type& e2)
+    edge_transform edge_to_edge_matrix(const tess::edge::impl_type& e1, const tess::edge::impl_type& e2)
     {
         auto u1 = e1.u();
         auto v1 = e1.v();
         auto u2 = e2.u();
         auto v2 = e2.v();
 
-        return tess::line_seg_to_line_seg({ u1->pos() , v1->pos() }, { v2->pos() , u2->pos() });
+        std::optional<tess::exact_transform> exact;
+        auto exact_u1 = u1->exact_pos();
+        auto exact_v1 = v1->exact_pos();
+        auto exact_u2 = u2->exact_pos();
+        auto exact_v2 = v2->exact_pos();
+        if (exact_u1 && exact_v1 && exact_u2 && exact_v2)
+            exact = tess::exact_transform::line_seg_to_line_seg(*exact_u1, *exact_v1, *exact_v2, *exact_u2);
+
+        return {
+            tess::line_seg_to_line_seg({ u1->pos() , v1->pos() }, { v2->pos() , u2->pos() }),
+            exact
+        };
     }
 
     tess::obj_id get_key(edge_parent_type obj)
@@ -88,6 +103,37 @@ namespace {
 
         return std::nullopt;
     }
+
+    // the reference interpreter's operand stack holds items rather than values, so ops
+    // that hand their operands on as values copy them into a buffer that is reused
+    // from op to op. Only one can be alive at a time.
+    class value_buffer {
+    public:
+        value_buffer(tess::stack_machine::operand_view<tess::stack_machine::item> operands, int first, int n) :
+            values_(buffer())
+        {
+            // bottom first, so that a view over the buffer reads top first.
+            values_.clear();
+            for (int i = first + n - 1; i >= first; --i)
+                values_.push_back(std::get<tess::value_>(operands[i]));
+        }
+
+        ~value_buffer() {
+            values_.clear();
+        }
+
+        tess::stack_machine::args_view view() const {
+            return { values_.data() + values_.size(), static_cast<int>(values_.size()) };
+        }
+
+    private:
+        static std::vector<tess::value_>& buffer() {
+            thread_local std::vector<tess::value_> values;
+            return values;
+        }
+
+        std::vector<tess::value_>& values_;
+    };
 }
 
 std::optional<tess::error> apply_mapping(const std::vector<edge_mapping>& mappings)
@@ -102,25 +148,138 @@ std::optional<tess::error> apply_mapping(const std::vector<edge_mapping>& mappin
     return std::nullopt;
 }
 
-tess::make_lambda::make_lambda(const std::vector<std::string>& parameters, const std::vector<stack_machine::item>& body, const std::vector<std::string>& deps) :
+const tess::value_& tess::get_variable(const tess::evaluation_context& ctxt, const tess::stack_machine::variable& var)
+{
+    auto val = var.is_resolved() ? ctxt.get(var.depth(), var.slot()) : nullptr;
+    if (!val)
+        throw tess::error("Unknown variable: " + var.name());
+    return *val;
+}
+
+void tess::assign_variables(tess::evaluation_context& ctxt, const std::vector<stack_machine::variable>& vars, const value_& value)
+{
+    // variables are always assigned in the innermost frame.
+    auto& current_scope = ctxt.peek();
+    if (vars.size() == 1) {
+        current_scope.set(vars[0].slot(), value);
+    } else {
+        int i = 0;
+        for (const auto& var : vars) 
+            current_scope.set(var.slot(), tess::get_ary_item(value, i++));
+    }
+}
+
+void tess::capture_variables(const tess::evaluation_context& ctxt, const lambda_root_ptr& lambda, const std::vector<stack_machine::variable>& captures)
+{
+    // dependencies that are not defined yet are filled in by set_dependencies.
+    for (int i = 0; i < static_cast<int>(captures.size()); ++i) {
+        const auto& var = captures[i];
+        auto val = var.is_resolved() ? ctxt.get(var.depth(), var.slot()) : nullptr;
+        if (val)
+            lambda->insert_field(i, *val);
+    }
+}
+
+void tess::set_dependencies(tess::evaluation_context& ctxt, const std::vector<stack_machine::variable>& visible)
+{
+    auto& frame = ctxt.peek();
+    for (int slot = 0; slot < frame.size(); ++slot) {
+        auto val = frame.get(slot);
+        if (val && std::holds_alternative<const_lambda_root_ptr>(*val)) {
+            auto dependencies = std::get<const_lambda_root_ptr>(*val)->unfulfilled_dependencies();
+            if (dependencies.empty())
+                continue;
+            if (tess::is_shared(*val)) {
+                auto copy = tess::clone_value(ctxt.allocator(), *val);
+                frame.set(slot, copy);
+                val = frame.get(slot);
+            }
+            auto func = get_mutable<tess::const_lambda_root_ptr>(*val);
+            for (const auto& dependency : dependencies) {
+                auto var = std::find_if(visible.begin(), visible.end(),
+                    [&dependency](const auto& v) { return v.name() == dependency; }
+                );
+                func->insert_field(dependency, 
+                    get_variable(ctxt, (var != visible.end()) ? *var : stack_machine::variable(dependency))
+                );
+            }
+        }
+    }
+}
+
+tess::scope_frame tess::make_call_frame(const tess::const_lambda_root_ptr& func, stack_machine::args_view args)
+{
+    if (static_cast<int>(func->parameters().size()) != args.size())
+        throw tess::error("func call arg count mismatch.");
+
+    // the body was compiled against a frame holding the parameters followed by the
+    // closure, see function_def::compile.
+    int num_args = args.size();
+    const auto& closure = func->closure();
+    scope_frame frame(num_args + static_cast<int>(closure.size()));
+    for (int i = 0; i < num_args; ++i)
+        frame.set(i, args[i]);
+    for (int i = 0; i < static_cast<int>(closure.size()); ++i)
+        if (closure[i].has_value())
+            frame.set(num_args + i, from_field_value(*closure[i]));
+    return frame;
+}
+
+tess::value_ tess::lay(tess::evaluation_context& ctxt, const std::vector<stack_machine::variable>& layees, stack_machine::args_view edges)
+{
+    std::vector<tess::value_> layee_values;
+    layee_values.reserve(layees.size());
+    for (const auto& var : layees)
+        layee_values.push_back(get_variable(ctxt, var));
+
+    std::vector<std::tuple<edge_root_ptr, edge_root_ptr>> edge_to_edge;
+    for (const auto& e : edges) {
+        if (!std::holds_alternative<tess::const_edge_root_ptr>(e))
+            throw tess::error("mapping argument in a lay or join expression does not evaluate to an edge.");
+    }
+    for (int i = 0; i < edges.size(); i += 2) {
+        auto edge1 = from_const(std::get<const_edge_root_ptr>(edges[i]));
+        auto edge2 = from_const(std::get<const_edge_root_ptr>(edges[i+1]));
+        edge_to_edge.push_back({ edge1, edge2} );
+    }
+    ::apply_mapping(edge_to_edge);
+
+    // the placeholders hold copies made for this lay, so the result takes their tiles.
+    return tess::make_value(
+        tess::flatten(ctxt.allocator(), layee_values, true, true)
+    );
+}
+
+void tess::set_fields(stack_machine::args_view field_refs, const value_& value)
+{
+    if (field_refs.size() == 1) {
+        std::get<field_ref_ptr>(field_refs[0])->set(value);
+    } else {
+        int i = 0;
+        for (const auto& field_ref : field_refs) {
+            std::get<field_ref_ptr>(field_ref)->set(tess::get_ary_item(value, i++));
+        }
+    }
+}
+
+tess::make_lambda::make_lambda(unsigned int id, const std::vector<std::string>& parameters, const std::vector<stack_machine::item>& body, const std::vector<std::string>& deps,
+        const std::vector<stack_machine::variable>& captures) :
     op_1(0),
+    id_(id),
     parameters_(parameters),
     body_(body),
-    dependencies_(deps)
+    dependencies_(deps),
+    captures_(captures)
 {
 }
 
-tess::stack_machine::item tess::make_lambda::execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const
+tess::stack_machine::item tess::make_lambda::execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const
 {
     auto& ctxt = contexts.top();
     auto& alloc = contexts.top().allocator();
     try {
-        auto lambda = alloc.make_mutable<tess::const_lambda_root_ptr>(parameters_, body_, dependencies_);
-
-        for (auto dependency : dependencies_)
-            if (ctxt.has(dependency))
-                lambda->insert_field(dependency, ctxt.get(dependency));
-
+        auto lambda = alloc.make_mutable<tess::const_lambda_root_ptr>(id_, parameters_, body_, dependencies_);
+        capture_variables(ctxt, lambda, captures_);
         return  make_expr_val_item(lambda) ;
     }  catch (tess::error e) {
         return { e };
@@ -157,17 +316,22 @@ std::string tess::make_lambda::to_string() const
     return ss.str();
 }
 
+void tess::make_lambda::emit(stack_machine::assembler& a) const
+{
+    a.emit(stack_machine::opcode::make_lambda,
+        a.add_lambda({ id_, parameters_, dependencies_, a.add_variable_list(captures_), a.add_block(body_) })
+    );
+}
+
 /*---------------------------------------------------------------------------------------------*/
 
-tess::get_var::get_var(bool eval) : op_multi(1), eval_parameterless_funcs_(eval)
+tess::get_var::get_var(const stack_machine::variable& var, bool eval) : op_multi(0), var_(var), eval_parameterless_funcs_(eval)
 {
 }
 
-std::vector<tess::stack_machine::item> tess::get_var::execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const
+std::vector<tess::stack_machine::item> tess::get_var::execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const
 {
-    auto& ctxt = contexts.top();
-    auto ident = std::get<stack_machine::variable>(operands[0]);
-    auto value = ctxt.get(ident.name());
+    auto value = get_variable(contexts.top(), var_);
 
     if (eval_parameterless_funcs_ && std::holds_alternative<const_lambda_root_ptr>(value)) {
         auto lambda_val = std::get<const_lambda_root_ptr>(value);
@@ -184,94 +348,86 @@ std::vector<tess::stack_machine::item> tess::get_var::execute(const std::vector<
     return std::vector<tess::stack_machine::item>{ {value} };
 }
 
+void tess::get_var::emit(stack_machine::assembler& a) const
+{
+    a.emit(stack_machine::opcode::get_var, a.add_variable(var_), eval_parameterless_funcs_ ? 1 : 0);
+}
+
 /*---------------------------------------------------------------------------------------------*/
 
 tess::pop_eval_context::pop_eval_context() : op_0(0)
 {
 }
 
-void tess::pop_eval_context::execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const
+void tess::pop_eval_context::execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const
 {
     contexts.pop();
 }
 
-/*---------------------------------------------------------------------------------------------*/
-
-std::string serialize_func_call(const tess::const_lambda_root_ptr& func, const std::vector<tess::value_>& args) {
-    std::stringstream ss;
-    ss << tess::serialize( {func} );
-    for (const auto& v : args) {
-        auto v_str = tess::serialize(v);
-        if (v_str.empty())
-            return {};
-        ss << " " << v_str;
-    }
-    return ss.str();
+void tess::pop_eval_context::emit(stack_machine::assembler& a) const
+{
+    a.emit(stack_machine::opcode::pop_context);
 }
 
-std::vector<tess::stack_machine::item> tess::call_func::execute(const std::vector<tess::stack_machine::item>& operands, tess::context_stack& contexts) const
+/*---------------------------------------------------------------------------------------------*/
+
+std::vector<tess::stack_machine::item> tess::call_func::execute(stack_machine::operand_view<tess::stack_machine::item> operands, tess::context_stack& contexts) const
 {
     //TODO: make a function that tests a stackitem for an expr_val containing type and throws if not there
     if (!std::holds_alternative<value_>(operands[0]) || !std::holds_alternative<const_lambda_root_ptr>(std::get<value_>(operands[0])))
         throw tess::error("Attempted to evaluate non-lambda");
 
     const_lambda_root_ptr func = std::get<const_lambda_root_ptr>(std::get<value_>(operands[0]));
-    std::vector<value_> args = get_vector<value_>(operands.begin() + 1, operands.end());
-
-    auto key = serialize_func_call(func, args);
-    auto& memo_tbl = contexts.memos();
-
-    //std::cout << key << "\n";
-    //std::cout << memo_tbl.size() << "\n";
+    value_buffer args(operands, 1, operands.size() - 1);
 
-    if ((key.empty()) || (!memo_tbl.contains(key))) {
+    memo_key key;
+    auto memo_val = contexts.memos().find(func, args.view(), key);
+    if (memo_val)
+        return std::vector<tess::stack_machine::item>{ {*memo_val} };
 
-        if (func->parameters().size() != args.size())
-            throw tess::error("func call arg count mismatch.");
+    contexts.top().push_scope(make_call_frame(func, args.view()));
 
-            scope_frame frame(func->parameters(), args);
-            for (auto iter = func->begin_closure(); iter != func->end_closure(); ++iter) {
-                const auto& [var, val] = *iter;
-                frame.set(var, from_field_value(val));
-            }
-            contexts.top().push_scope(frame);
-
-            auto func_body = func->body();
-            func_body.push_back(
-                { std::make_shared<memoize_func_call_op>(key) }
-        );
+    auto func_body = func->body();
+    func_body.push_back(
+        { std::make_shared<memoize_func_call_op>(std::move(key)) }
+    );
 
-        return func_body;
-    } else {
-        auto memo_val = memo_tbl.get(key);
-        auto& heap = contexts.top().allocator();
-        return std::vector<tess::stack_machine::item>{ {tess::clone_value(heap, memo_val)} };
-    }
+    return func_body;
 }
 
 tess::call_func::call_func(int num_args) : op_multi(num_args+1)
 {
 }
 
+void tess::call_func::emit(stack_machine::assembler& a) const
+{
+    a.emit(stack_machine::opcode::call, number_of_args_ - 1);
+}
+
 /*---------------------------------------------------------------------------------------------*/
 
 tess::push_eval_context::push_eval_context() : stack_machine::op_0(0)
 {
 }
 
-void tess::push_eval_context::execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const
+void tess::push_eval_context::execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const
 {
     auto& ctxt = contexts.top();
     contexts.push(ctxt.execution_state().create_eval_context());
 }
 
+void tess::push_eval_context::emit(stack_machine::assembler& a) const
+{
+    a.emit(stack_machine::opcode::push_context);
+}
+
 /*---------------------------------------------------------------------------------------------*/
 
 tess::pop_frame_op::pop_frame_op() : tess::stack_machine::op_0(0)
 {
 }
 
-void tess::pop_frame_op::execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const
+void tess::pop_frame_op::execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const
 {
     if (contexts.empty())
         throw tess::error("context stack underflow");
@@ -279,45 +435,46 @@ void tess::pop_frame_op::execute(const std::vector<stack_machine::item>& operand
     if (contexts.top().empty())
         throw tess::error("eval context underflow");
 
-    auto scope = contexts.top().pop_scope();
+    contexts.top().pop_scope();
+}
+
+void tess::pop_frame_op::emit(stack_machine::assembler& a) const
+{
+    a.emit(stack_machine::opcode::pop_frame);
 }
 
 /*---------------------------------------------------------------------------------------------*/
 
-tess::push_frame_op::push_frame_op() : tess::stack_machine::op_0(0)
+tess::push_frame_op::push_frame_op(int num_slots) : tess::stack_machine::op_0(0), num_slots_(num_slots)
 {
 }
 
-void tess::push_frame_op::execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const
+void tess::push_frame_op::execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const
 {
     if (contexts.empty())
         throw tess::error("context stack underflow");
-    contexts.top().push_scope(scope_frame());
+    contexts.top().push_scope(scope_frame(num_slots_));
+}
+
+void tess::push_frame_op::emit(stack_machine::assembler& a) const
+{
+    a.emit(stack_machine::opcode::push_frame, num_slots_);
 }
 
 /*---------------------------------------------------------------------------------------------*/
 
-tess::assign_op::assign_op(int num_vars) : stack_machine::op_0(num_vars+1)
+tess::assign_op::assign_op(const std::vector<stack_machine::variable>& vars) : stack_machine::op_0(1), vars_(vars)
 {
 }
 
-void tess::assign_op::execute(const std::vector<tess::stack_machine::item>& operands, tess::context_stack& contexts) const
+void tess::assign_op::execute(stack_machine::operand_view<tess::stack_machine::item> operands, tess::context_stack& contexts) const
 {
-    int num_vars = static_cast<int>(operands.size() - 1);
-    auto value = std::get<value_>(operands.back());
-    std::vector<stack_machine::variable> vars(num_vars);
-    std::transform(operands.begin(), operands.begin() + num_vars, vars.begin(),
-        [](const auto& item) { return std::get<stack_machine::variable>(item); }
-    );
+    assign_variables(contexts.top(), vars_, std::get<value_>(operands[0]));
+}
 
-    auto& current_scope = contexts.top().peek();
-    if (num_vars == 1) {
-        current_scope.set(vars[0].name(), value);
-    } else {
-        int i = 0;
-        for (const auto& var : vars) 
-            current_scope.set(var.name(), tess::get_ary_item(value, i++));
-    }
+void tess::assign_op::emit(stack_machine::assembler& a) const
+{
+    a.emit(stack_machine::opcode::assign, a.add_variable_list(vars_));
 }
 
 tess::one_param_op::one_param_op(std::function<value_(tess::gc_heap&, const value_&)> func, std::string name) :
@@ -325,19 +482,32 @@ tess::one_param_op::one_param_op(std::function<value_(tess::gc_heap&, const valu
 {
 }
 
-tess::stack_machine::item tess::one_param_op::execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const
+tess::stack_machine::item tess::one_param_op::execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const
 {
     return {
         func_(contexts.top().allocator(), std::get<value_>(operands[0]))
     };
 }
 
+void tess::one_param_op::emit(stack_machine::assembler& a) const
+{
+    auto func = func_;
+    a.emit(stack_machine::opcode::call_native,
+        a.add_native(name_, 
+            [func](gc_heap& a, stack_machine::args_view args)->value_ {
+                return func(a, args[0]);
+            }
+        ),
+        1
+    );
+}
+
 tess::get_field_op::get_field_op(const std::string& field, bool get_ref) : 
     stack_machine::op_1(1), field_(field), get_ref_(get_ref)
 {
 }
 
-tess::stack_machine::item tess::get_field_op::execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const
+tess::stack_machine::item tess::get_field_op::execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const
 {
     value_ val = std::get<value_>(operands[0]);
     if (!get_ref_) {
@@ -356,28 +526,20 @@ std::string tess::get_field_op::to_string() const
         return std::string("<get_field_ref ") + field_ + ">";
 }
 
-tess::lay_op::lay_op(int num_mappings) : stack_machine::op_1(2*num_mappings)
+void tess::get_field_op::emit(stack_machine::assembler& a) const
 {
+    a.emit(stack_machine::opcode::get_field, a.add_string(field_), get_ref_ ? 1 : 0);
 }
 
-std::vector<tess::value_> get_layees(const tess::evaluation_context& ctxt) {
-    std::vector<tess::value_> values;
-    for (int i = 1; ctxt.has(std::to_string(i)); ++i) {
-        values.push_back(ctxt.get(std::to_string(i)));
-    }
-    return values;
+tess::lay_op::lay_op(int num_mappings, const std::vector<stack_machine::variable>& layees) : 
+    stack_machine::op_1(2*num_mappings), layees_(layees)
+{
 }
 
-tess::stack_machine::item tess::lay_op::execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const
+tess::stack_machine::item tess::lay_op::execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const
 { 
-    auto& ctxt = contexts.top();
-    auto layees = get_layees(ctxt);
-    auto result = apply_mapping(operands);
-    return  {
-        tess::make_value(
-            tess::flatten(ctxt.allocator(), layees, true)
-        )
-    };
+    value_buffer edges(operands, 0, operands.size());
+    return { lay(contexts.top(), layees_, edges.view()) };
 }
 
 std::string tess::lay_op::to_string() const
@@ -385,34 +547,25 @@ std::string tess::lay_op::to_string() const
     return std::string("<lay " + std::to_string(number_of_args_/2) + ">");
 }
 
-std::optional<tess::error> tess::lay_op::apply_mapping(const std::vector<stack_machine::item>& operands) const
+void tess::lay_op::emit(stack_machine::assembler& a) const
 {
-    auto values = get_vector<value_>(operands.begin(), operands.end());
-    std::vector<std::tuple<edge_root_ptr, edge_root_ptr>> edge_to_edge;
-
-    for (const auto& e : values) {
-        if (!std::holds_alternative<tess::const_edge_root_ptr>(e))
-            throw tess::error("mapping argument in a lay or join expression does not evaluate to an edge.");
-    }
-
-    for (int i = 0; i < values.size(); i += 2) {
-        auto edge1 = from_const(std::get<const_edge_root_ptr>(values[i]));
-        auto edge2 = from_const(std::get<const_edge_root_ptr>(values[i+1]));
-        edge_to_edge.push_back({ edge1, edge2} );
-    }
-
-    return ::apply_mapping(edge_to_edge);
+    a.emit(stack_machine::opcode::lay, a.add_variable_list(layees_), number_of_args_ / 2);
 }
 
-tess::val_func_op::val_func_op(int n, std::function<value_(tess::gc_heap& a, const std::vector<value_> & v)> func, std::string name) :
+tess::val_func_op::val_func_op(int n, stack_machine::native_func func, std::string name) :
     stack_machine::op_1(n), name_(name), func_(func)
 {
 }
 
-tess::stack_machine::item tess::val_func_op::execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const
+tess::stack_machine::item tess::val_func_op::execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const
+{
+    value_buffer args(operands, 0, operands.size());
+    return { func_( contexts.top().allocator(), args.view() ) };
+}
+
+void tess::val_func_op::emit(stack_machine::assembler& a) const
 {
-    std::vector<value_> args = get_vector<value_>(operands.begin(), operands.end());
-    return { func_( contexts.top().allocator(), args ) };
+    a.emit(stack_machine::opcode::call_native, a.add_native(name_, func_), number_of_args_);
 }
 
 tess::if_op::if_op(const std::vector<stack_machine::item>& if_clause, const std::vector<stack_machine::item>& else_clause) :
@@ -420,7 +573,7 @@ tess::if_op::if_op(const std::vector<stack_machine::item>& if_clause, const std:
 {
 }
 
-std::vector<tess::stack_machine::item> tess::if_op::execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const
+std::vector<tess::stack_machine::item> tess::if_op::execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const
 {
     bool cond = std::get<bool>(std::get<value_>(operands[0]));
     return (cond) ?
@@ -473,17 +626,54 @@ std::string tess::if_op::to_string() const
     return ss.str();
 }
 
+void tess::if_op::emit(stack_machine::assembler& a) const
+{
+    int if_block = a.add_block(if_);
+    int else_block = a.add_block(else_);
+    a.emit(stack_machine::opcode::branch, if_block, else_block);
+}
+
+tess::fork_op::fork_op(const std::vector<std::vector<stack_machine::item>>& operands, const std::vector<std::vector<stack_machine::variable>>& inputs,
+        const std::vector<stack_machine::item>& serial) :
+    stack_machine::op_multi(0), operands_(operands), inputs_(inputs), serial_(serial)
+{
+}
+
+std::vector<tess::stack_machine::item> tess::fork_op::execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const
+{
+    return serial_;
+}
+
+std::string tess::fork_op::to_string() const
+{
+    return "<fork " + std::to_string(operands_.size()) + ">";
+}
+
+void tess::fork_op::emit(stack_machine::assembler& a) const
+{
+    std::vector<stack_machine::task_template> tasks;
+    for (size_t i = 0; i < operands_.size(); ++i)
+        tasks.push_back({ a.add_block(operands_[i]), a.add_variable_list(inputs_[i]) });
+    int serial = a.add_block(serial_);
+    a.emit(stack_machine::opcode::fork, a.add_fork(tasks), serial);
+}
+
 tess::get_ary_item_op::get_ary_item_op() : stack_machine::op_1(2)
 {
 }
 
-tess::stack_machine::item tess::get_ary_item_op::execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const
+tess::stack_machine::item tess::get_ary_item_op::execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const
 {
     auto ary = std::get<value_>(operands[0]);
     auto index = std::get<tess::number>(std::get<value_>(operands[1]));
     return { tess::get_ary_item(ary, tess::to_int(index)) };
 }
 
+void tess::get_ary_item_op::emit(stack_machine::assembler& a) const
+{
+    a.emit(stack_machine::opcode::get_ary_item);
+}
+
 
 std::vector<tess::stack_machine::item> tess::iterate_op::start_next_item(int index, tess::const_cluster_root_ptr ary) const
 {
@@ -491,14 +681,13 @@ std::vector<tess::stack_machine::item> tess::iterate_op::start_next_item(int ind
         { value_{number(index)} },
         { value_{ary} },
         { std::make_shared<get_ary_item_op>() },
-        { stack_machine::variable(index_var_) },
-        { std::make_shared<assign_op>(1) }
+        { std::make_shared<assign_op>(std::vector<stack_machine::variable>{ index_var_ }) }
     };
     std::copy(body_.begin(), body_.end(), std::back_inserter(output));
     return output;
 }
 
-tess::iterate_op::iterate_op(std::string index_var, int index_val, const std::vector<stack_machine::item>& body) :
+tess::iterate_op::iterate_op(const stack_machine::variable& index_var, int index_val, const std::vector<stack_machine::item>& body) :
     stack_machine::op_multi(3),
     index_var_(index_var),
     index_val_(index_val),
@@ -506,7 +695,7 @@ tess::iterate_op::iterate_op(std::string index_var, int index_val, const std::ve
 {
 }
 
-std::vector<tess::stack_machine::item> tess::iterate_op::execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const
+std::vector<tess::stack_machine::item> tess::iterate_op::execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const
 {
     auto& alloc = contexts.top().allocator();
     auto src = std::get<tess::const_cluster_root_ptr>(std::get<value_>( operands[0] ));
@@ -548,66 +737,66 @@ tess::cluster_root_ptr{};
 std::string tess::iterate_op::to_string() const
 {
     std::stringstream ss;
-    ss << "<iterate " << index_var_ << " " << std::to_string(index_val_) << " {";
+    ss << "<iterate " << index_var_.to_string() << " " << std::to_string(index_val_) << " {";
     for (auto it : body_)
         ss << it.to_string() << ";";
     ss << "}>";
     return ss.str();
 }
 
-tess::set_dependencies_op::set_dependencies_op() : stack_machine::op_0(0)
+void tess::iterate_op::emit(stack_machine::assembler& a) const
 {
+    // iterate_ops after the first are only created at runtime. The body block ends 
+    // with an iterate_next that loops back to its start.
+    int var = a.add_variable(index_var_);
+    int body = a.add_block(body_);
+    a.append(body, stack_machine::opcode::iterate_next, var, a.block_size(body) + 1);
+    a.emit(stack_machine::opcode::iterate_begin, var, body);
 }
 
-void tess::set_dependencies_op::execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const
+tess::set_dependencies_op::set_dependencies_op(const std::vector<stack_machine::variable>& visible) : 
+    stack_machine::op_0(0), visible_(visible)
 {
-    auto& ctxt = contexts.top();
-    auto& frame = ctxt.peek();
-    for (auto& val : frame.values()) {
-        if (std::holds_alternative<const_lambda_root_ptr>(val)) {
-            std::vector<std::string> vars;
-            auto func = get_mutable<tess::const_lambda_root_ptr>(val);
-            for (const auto& var : func->unfulfilled_dependencies())   
-                func->insert_field(var, ctxt.get(var));
-        }
-    }
+}
+
+void tess::set_dependencies_op::execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const
+{
+    set_dependencies(contexts.top(), visible_);
+}
+
+void tess::set_dependencies_op::emit(stack_machine::assembler& a) const
+{
+    a.emit(stack_machine::opcode::set_dependencies, a.add_variable_list(visible_));
 }
 
 tess::set_field_op::set_field_op(int num_fields) : stack_machine::op_0(num_fields + 1)
 {
 }
 
-void tess::set_field_op::execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const
+void tess::set_field_op::execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const
 {
-    int num_fields = static_cast<int>(operands.size() - 1);
-    auto value = std::get<value_>(operands.back());
-    std::vector<tess::field_ref_ptr> field_refs(num_fields);
-    std::transform(operands.begin(), operands.begin() + num_fields, field_refs.begin(),
-        [](const auto& item) { 
-            return std::get<field_ref_ptr>(std::get<value_>(item));
-        }
-    );
+    value_buffer field_refs(operands, 0, operands.size() - 1);
+    set_fields(field_refs.view(), std::get<value_>(operands.back()));
+}
 
-    if (num_fields == 1) {
-        field_refs[0]->set(value);
-    } else {
-        int i = 0;
-        for (auto& field_ref : field_refs) {
-            field_ref->set(tess::get_ary_item(value, i++));
-        }
-    }
+void tess::set_field_op::emit(stack_machine::assembler& a) const
+{
+    a.emit(stack_machine::opcode::set_field, number_of_args_ - 1);
 }
 
-tess::memoize_func_call_op::memoize_func_call_op(std::string func_call_key) : stack_machine::op_1(1),
-    key_(func_call_key)
+tess::memoize_func_call_op::memoize_func_call_op(memo_key key) : stack_machine::op_1(1),
+    key_(std::move(key))
 {
 }
 
-tess::stack_machine::item tess::memoize_func_call_op::execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const
+tess::stack_machine::item tess::memoize_func_call_op::execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const
 {
     auto val = std::get<value_>(operands[0]);
-    if (!key_.empty()) {
-        contexts.memos().insert(key_, val);
-    }
+    contexts.memos().insert(key_, val);
     return { val };
 }
+
+void tess::memoize_func_call_op::emit(stack_machine::assembler& a) const
+{
+    throw tess::error("memoize ops are only created at runtime.");
+}
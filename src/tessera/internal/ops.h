@@ -7,6 +7,15 @@
 
 namespace tess {
 
+    // the semantics shared by the op classes and the bytecode machine.
+    const value_& get_variable(const evaluation_context& ctxt, const stack_machine::variable& var);
+    void assign_variables(evaluation_context& ctxt, const std::vector<stack_machine::variable>& vars, const value_& value);
+    void capture_variables(const evaluation_context& ctxt, const lambda_root_ptr& lambda, const std::vector<stack_machine::variable>& captures);
+    void set_dependencies(evaluation_context& ctxt, const std::vector<stack_machine::variable>& visible);
+    scope_frame make_call_frame(const const_lambda_root_ptr& func, stack_machine::args_view args);
+    value_ lay(evaluation_context& ctxt, const std::vector<stack_machine::variable>& layees, stack_machine::args_view edges);
+    void set_fields(stack_machine::args_view field_refs, const value_& value);
+
 
     template <typename T>
     T get_from_item(const stack_machine::item& item) {
@@ -25,66 +34,81 @@ namespace tess {
 
     class make_lambda : public stack_machine::op_1 {
     public:
-        make_lambda(const std::vector<std::string>& parameters, const std::vector<stack_machine::item>& body, const std::vector<std::string>& deps);
+        make_lambda(unsigned int id, const std::vector<std::string>& parameters, const std::vector<stack_machine::item>& body, const std::vector<std::string>& deps, 
+            const std::vector<stack_machine::variable>& captures);
     protected:
-        stack_machine::item execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const override;
+        stack_machine::item execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const override;
         std::string to_string() const override;
+        void emit(stack_machine::assembler& a) const override;
+        unsigned int id_;
         std::vector<std::string> parameters_;
         std::vector<std::string> dependencies_;
+        std::vector<stack_machine::variable> captures_;
         std::vector<stack_machine::item> body_;
     };
 
     class get_var : public stack_machine::op_multi {
     public:
-        get_var(bool eval_parameterless_funcs = true);
+        get_var(const stack_machine::variable& var, bool eval_parameterless_funcs = true);
     protected:
-       std::vector<stack_machine::item> execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const override;
-       std::string to_string() const override { return "<get>"; }
+       std::vector<stack_machine::item> execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const override;
+       std::string to_string() const override { return "<get " + var_.to_string() + ">"; }
+       void emit(stack_machine::assembler& a) const override;
+       stack_machine::variable var_;
        bool eval_parameterless_funcs_;
     };
 
     class pop_eval_context : public stack_machine::op_0 {
     public:
         pop_eval_context();
-        void execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const override;
+        void execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const override;
         std::string to_string() const override { return "<pop_context>"; }
+        void emit(stack_machine::assembler& a) const override;
     };
 
     class call_func : public stack_machine::op_multi {
     protected:
-        std::vector<stack_machine::item> execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const override;
+        std::vector<stack_machine::item> execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const override;
     public:
         call_func(int num_args);
         std::string to_string() const override { return "<apply " + std::to_string(number_of_args_ - 1) + ">"; }
+        void emit(stack_machine::assembler& a) const override;
     };
 
     class push_eval_context : public stack_machine::op_0 {
     public:
         push_eval_context();
-        void execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const override;
+        void execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const override;
         std::string to_string() const override { return "<push_context>"; }
+        void emit(stack_machine::assembler& a) const override;
     };
     
     class pop_frame_op : public stack_machine::op_0 {
     public:
         pop_frame_op();
-        void execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const override;
+        void execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const override;
         std::string to_string() const override { return "<pop_frame>"; }
+        void emit(stack_machine::assembler& a) const override;
     };
 
     class push_frame_op : public stack_machine::op_0 {
     public:
-        push_frame_op();
-        void execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const override;
-        std::string to_string() const override { return "<push_frame>"; }
+        push_frame_op(int num_slots);
+        void execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const override;
+        std::string to_string() const override { return "<push_frame " + std::to_string(num_slots_) + ">"; }
+        void emit(stack_machine::assembler& a) const override;
+    protected:
+        int num_slots_;
     };
 
     class assign_op : public stack_machine::op_0 {
     public:
-        assign_op(int num_vars);
+        assign_op(const std::vector<stack_machine::variable>& vars);
     protected:
-        void execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const override;
-        std::string to_string() const override { return "<assign " + std::to_string(number_of_args_-1) + ">"; }
+        void execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const override;
+        std::string to_string() const override { return "<assign " + std::to_string(vars_.size()) + ">"; }
+        void emit(stack_machine::assembler& a) const override;
+        std::vector<stack_machine::variable> vars_;
     };
 
     class one_param_op : public stack_machine::op_1 {
@@ -93,19 +117,21 @@ namespace tess {
     protected:
         std::string name_;
         std::function<value_(gc_heap & a, const value_ & v)> func_;
-        stack_machine::item execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const override;
+        stack_machine::item execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const override;
         std::string to_string() const override { return name_; }
+        void emit(stack_machine::assembler& a) const override;
 
     };
 
     class val_func_op : public stack_machine::op_1 {
     public:
-        val_func_op(int n, std::function<value_(gc_heap& a, const std::vector<value_>& v)> func, std::string name);
+        val_func_op(int n, stack_machine::native_func func, std::string name);
     protected:
         std::string name_;
-        std::function<value_(gc_heap& a, const std::vector<value_> & v)> func_;
-        stack_machine::item execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const override;
+        stack_machine::native_func func_;
+        stack_machine::item execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const override;
         std::string to_string() const override { return name_; }
+        void emit(stack_machine::assembler& a) const override;
 
     };
 
@@ -116,77 +142,103 @@ namespace tess {
         std::string field_;
         bool get_ref_;
 
-        stack_machine::item execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const override;
+        stack_machine::item execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const override;
         std::string to_string() const override;
+        void emit(stack_machine::assembler& a) const override;
     };
 
     class set_field_op: public stack_machine::op_0{
     public:
         set_field_op(int fields);
     protected:
-        void execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const override;
+        void execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const override;
         std::string to_string() const override { return "<set_field " + std::to_string(number_of_args_ - 1) + ">"; }
+        void emit(stack_machine::assembler& a) const override;
     };
 
     class lay_op : public stack_machine::op_1 {
     public:
-        lay_op(int num_mappings);
+        lay_op(int num_mappings, const std::vector<stack_machine::variable>& layees);
     protected:
-        stack_machine::item execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const override;
-        std::string to_string() const override;
+        std::vector<stack_machine::variable> layees_;
 
-        std::optional<tess::error> apply_mapping(const std::vector<stack_machine::item>& operands) const;
+        stack_machine::item execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const override;
+        std::string to_string() const override;
+        void emit(stack_machine::assembler& a) const override;
     };
 
     class if_op : public stack_machine::op_multi {
     public:
         if_op(const std::vector<stack_machine::item>& if_clause, const std::vector<stack_machine::item>& else_clause);
     protected:
-        std::vector<stack_machine::item> execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const override;
+        std::vector<stack_machine::item> execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const override;
         std::string to_string() const override;
+        void emit(stack_machine::assembler& a) const override;
 
         std::vector<stack_machine::item> if_;
         std::vector<stack_machine::item> else_;
     };
 
+    // operands that do not depend on each other, each leaving one value, and the variables
+    // each reads. The reference interpreter always runs serial, the same operands one after
+    // another; a parallel machine can run them at once, see stack_machine::machine.
+    class fork_op : public stack_machine::op_multi {
+    public:
+        fork_op(const std::vector<std::vector<stack_machine::item>>& operands, const std::vector<std::vector<stack_machine::variable>>& inputs,
+            const std::vector<stack_machine::item>& serial);
+    protected:
+        std::vector<stack_machine::item> execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const override;
+        std::string to_string() const override;
+        void emit(stack_machine::assembler& a) const override;
+
+        std::vector<std::vector<stack_machine::item>> operands_;
+        std::vector<std::vector<stack_machine::variable>> inputs_;
+        std::vector<stack_machine::item> serial_;
+    };
+
     class get_ary_item_op : public stack_machine::op_1 {
     public:
         get_ary_item_op();
     protected:
-        stack_machine::item execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const override;
+        stack_machine::item execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const override;
         std::string to_string() const override { return "<get_ary_item>"; }
+        void emit(stack_machine::assembler& a) const override;
     };
 
     class iterate_op : public stack_machine::op_multi {
     protected:
-        std::vector<stack_machine::item> execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const override;
+        std::vector<stack_machine::item> execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const override;
 
-        std::string index_var_;
+        stack_machine::variable index_var_;
         int index_val_;
         std::vector<stack_machine::item> body_;
 
         std::vector<stack_machine::item> start_next_item(int index, tess::const_cluster_root_ptr ary) const;
 
     public:
-        iterate_op(std::string index_var, int index_val, const std::vector<stack_machine::item>& body);
+        iterate_op(const stack_machine::variable& index_var, int index_val, const std::vector<stack_machine::item>& body);
         std::string to_string() const override;
+        void emit(stack_machine::assembler& a) const override;
     };
 
     class set_dependencies_op : public stack_machine::op_0 {
     public:
-        set_dependencies_op();
+        set_dependencies_op(const std::vector<stack_machine::variable>& visible);
     protected:
-        void execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const override;
+        void execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const override;
         std::string to_string() const override { return "<set dependencies>"; }
+        void emit(stack_machine::assembler& a) const override;
+        std::vector<stack_machine::variable> visible_;
     };
 
     class memoize_func_call_op : public stack_machine::op_1 {
     public:
-        memoize_func_call_op(std::string func_call_key);
+        memoize_func_call_op(memo_key key);
     protected:
-        std::string key_;
+        memo_key key_;
 
-        stack_machine::item execute(const std::vector<stack_machine::item>& operands, tess::context_stack& contexts) const override;
-        std::string to_string() const override { return "<get_ary_item " + key_ + ">"; }
+        stack_machine::item execute(stack_machine::operand_view<stack_machine::item> operands, tess::context_stack& contexts) const override;
+        std::string to_string() const override { return "<memoize>"; }
+        void emit(stack_machine::assembler& a) const override;
     };
 }
\ No newline at end of file
@@ -66,28 +66,32 @@ tess::parser::kw& tess::parser::operator++(tess::parser::kw& val)
 
 const std::string& tess::parser::keyword(tess::parser::kw tok)
 {
-    static std::unordered_map<tess::parser::kw, std::string> keyword_tbl;
-    if (keyword_tbl.empty()) {
+    // built by the first call; static initialization is thread-safe where filling an
+    // empty table on first use was not.
+    static const std::unordered_map<tess::parser::kw, std::string> keyword_tbl = []() {
+        std::unordered_map<tess::parser::kw, std::string> tbl;
         const auto keywords = keyword_list();
-        std::transform(keywords.begin(), keywords.end(), std::inserter(keyword_tbl, keyword_tbl.end()),
+        std::transform(keywords.begin(), keywords.end(), std::inserter(tbl, tbl.end()),
             [](const auto& tup) -> std::unordered_map<tess::parser::kw, std::string>::value_type {
                 return { std::get<0>(tup), std::get<1>(tup) };
             }
         );
-    }
+        return tbl;
+    }();
     return keyword_tbl.at(tok);
 }
 
 tess::parser::kw tess::parser::token(std::string keyword)
 {
-    static std::unordered_map<std::string, tess::parser::kw> token_tbl;
-    if (token_tbl.empty()) {
+    static const std::unordered_map<std::string, tess::parser::kw> token_tbl = []() {
+        std::unordered_map<std::string, tess::parser::kw> tbl;
         const auto keywords = keyword_list();
-        std::transform(keywords.begin(), keywords.end(), std::inserter(token_tbl, token_tbl.end()),
+        std::transform(keywords.begin(), keywords.end(), std::inserter(tbl, tbl.end()),
             [](const auto& tup) -> std::unordered_map<std::string, tess::parser::kw>::value_type {
                 return { std::get<1>(tup), std::get<0>(tup) };
             }
         );
-    }
+        return tbl;
+    }();
     return token_tbl.at(keyword);
 }
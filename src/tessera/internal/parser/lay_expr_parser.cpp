@@ -77,8 +77,44 @@ namespace tess {
             _val(ctx) = p; 
         };
 
+        // layees that do not refer to each other's placeholders or aliases are evaluated
+        // by one fork, see fork_expr.
+        bool are_independent(const std::vector<layee_param>& vals) {
+            std::unordered_set<std::string> names;
+            for (int i = 0; i < vals.size(); i++) {
+                names.insert(std::to_string(i + 1));
+                if (!vals[i].alias.empty())
+                    names.insert(vals[i].alias);
+            }
+            for (const auto& layee : vals) {
+                std::unordered_set<std::string> dependencies;
+                layee.layee->get_dependencies(dependencies);
+                for (const auto& dependency : dependencies)
+                    if (names.find(dependency) != names.end())
+                        return false;
+            }
+            return true;
+        }
+
         tess::assignment_block get_placeholder_assignments(const std::vector<layee_param> vals) {
             std::vector<tess::var_assignment> assignments;
+            if (vals.size() > 1 && are_independent(vals)) {
+                std::vector<std::string> vars;
+                std::vector<tess::expr_ptr> layees;
+                for (int i = 0; i < vals.size(); i++) {
+                    vars.push_back(std::to_string(i + 1));
+                    layees.push_back(vals[i].layee);
+                }
+                assignments.emplace_back(vars, std::make_shared<tess::fork_expr>(layees));
+                for (int i = 0; i < vals.size(); i++) {
+                    if (!vals[i].alias.empty()) {
+                        auto alias_val = std::make_shared<tess::var_expr>(vars[i]);
+                        assignments.emplace_back(std::vector<std::string>{vals[i].alias}, alias_val);
+                    }
+                }
+                return tess::assignment_block(assignments);
+            }
+
             for (int i = 0; i < vals.size(); i++) {
                 auto var = std::to_string(i + 1);
                 const auto& layee = vals[i];
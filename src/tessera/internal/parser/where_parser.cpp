@@ -25,7 +25,7 @@ namespace tess {
 		x3::rule<class asgn_stmt_, var_assignment> assignment_stmt = "assignment_stmt";
 		x3::rule<class where_expression_, expr_ptr> where_expr = "where_expr";
 
-		auto make_vector = [](auto& ctx) { _val(ctx) = std::vector<std::string>{ _attr(ctx) }; };
+		const auto make_vector = [](auto& ctx) { _val(ctx) = std::vector<std::string>{ _attr(ctx) }; };
 
 		const auto expr = expression_();
 		const auto identifier = indentifier_str_();
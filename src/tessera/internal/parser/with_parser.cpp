@@ -45,7 +45,7 @@ namespace tess {
 
 		expr_ptr unpack_obj_list(const obj_ref_list_t& ol);
 		auto make_lhs = [](auto& ctx) { _val(ctx) = unpack_obj_list(_attr(ctx)); };
-		auto make_vector = [](auto& ctx) {
+		const auto make_vector = [](auto& ctx) {
 			std::vector<tess::expr_ptr> vec;
 			vec.push_back(_attr(ctx));
 			_val(ctx) = vec; 
@@ -1,5 +1,6 @@
 #include "tessera/script.h"
 #include <utility>
+#include <unordered_set>
 #include "tessera/tile_patch.h"
 #include "tile_impl.h"
 #include "tile_patch_impl.h"
@@ -11,7 +12,10 @@
 #include "parser/expr_parser.h"
 #include "gc_heap.h"
 #include "execution_state.h"
+#include "bytecode.h"
 #include "object_expr.h"
+#include "ops.h"
+#include "memo_store.h"
 
 namespace {
 
@@ -33,30 +37,58 @@ namespace {
 	}
 
 
-	tess::result extract_tiles(const tess::value_& output) {
+	// what the tiles an execution returns point into: its state, which holds the heap
+	// they live in, and its output, which keeps them rooted.
+	struct execution_output {
+		tess::execution_state state;
+		tess::value_ value;
+	};
 
-		if (std::holds_alternative<tess::const_tile_root_ptr>(output))
-			return std::vector<tess::tile>{ tess::make_tess_obj<tess::tile>( std::get<tess::const_tile_root_ptr>(output).get() ) };
-		if (!std::holds_alternative<tess::const_patch_root_ptr>(output))
+	tess::result extract_tiles(const std::shared_ptr<const execution_output>& output) {
+
+		const auto& value = output->value;
+		if (std::holds_alternative<tess::const_tile_root_ptr>(value))
+			return std::vector<tess::tile>{ tess::make_tess_obj<tess::tile>( std::get<tess::const_tile_root_ptr>(value).get(), output ) };
+		if (!std::holds_alternative<tess::const_patch_root_ptr>(value))
 			return { tess::error("tableau does not evaulate to a tile patch.") };
 
-		auto patch = std::get<tess::const_patch_root_ptr>(output);
+		auto patch = std::get<tess::const_patch_root_ptr>(value);
 		std::vector<tess::tile> tiles(patch->count());
 		std::transform(patch->begin_tiles(), patch->end_tiles(), tiles.begin(),
-			[](const auto& i)->tess::tile {
+			[&output](const auto& i)->tess::tile {
 				auto root_ptr = tess::to_root_ptr(i);
-				return tess::make_tess_obj<tess::tile>(root_ptr.get());
+				return tess::make_tess_obj<tess::tile>(root_ptr.get(), output);
 			}
 		);
 
 		return { tiles };
 	}
+
+	bool refers_to_variables(const std::vector<tess::expr_ptr>& args) {
+		std::unordered_set<std::string> dependencies;
+		for (const auto& arg : args)
+			arg->get_dependencies(dependencies);
+		return !dependencies.empty();
+	}
+
+	// the code calling the tableau function with the arguments of an execution.
+	void compile_tableau_call(tess::stack_machine::stack& stack, const tess::value_& tableau, 
+			const std::vector<tess::expr_ptr>& args, tess::stack_machine::scope& scope) {
+		stack.push(std::make_shared<tess::pop_eval_context>());
+		stack.push(std::make_shared<tess::call_func>(static_cast<int>(args.size())));
+		stack.push(std::make_shared<tess::push_eval_context>());
+		stack.push(tableau);
+		stack.compile_and_push(args, scope);
+	}
 }
 
 std::variant<tess::script, tess::error> tess::script::parse(const std::string& script)
 {
 	text_range source_code{ script };
-	return tess::parser::parse(source_code);
+	auto result = tess::parser::parse(source_code);
+	if (std::holds_alternative<tess::script>(result))
+		std::get<tess::script>(result).impl_->set_fingerprint(memo_store::fingerprint(script));
+	return result;
 }
 
 const std::vector<std::string>& tess::script::parameters() const
@@ -72,17 +104,44 @@ tess::result tess::script::execute(const std::vector<std::string>& arg_strings)
 			return std::get<tess::error>(maybe_args);
 		auto args = std::get<std::vector<expr_ptr>>(maybe_args);
 
-		expr_ptr eval_script_expr = std::make_shared<where_expr>(
-            impl_->globals(),
+		// each execution gets a state of its own, so a script can be executed on several
+		// threads at once and nothing one execution leaves behind is seen by the next.
+		auto output = std::make_shared<execution_output>();
+		auto& state = output->state;
+		auto& memos = state.context_stack().memos();
+		if (auto store = impl_->memo_store())
+			memos.attach(store, state.allocator());
+
+		stack_machine::machine sm(impl_->parallel());
+#ifdef TESSERA_REFERENCE_INTERPRETER
+		stack_machine::scope scope;
+		std::make_shared<where_expr>(
+			impl_->globals(),
 			std::make_shared<func_call_expr>(impl_->tableau(), args)
-		);
-
-		auto& state = impl_->state();
-		std::string expr_str = eval_script_expr->to_string();
-		eval_script_expr->compile(state.main_stack());
-		std::string stack_str = state.main_stack().to_formatted_string();
-		stack_machine::machine sm;
-		auto output = sm.run(state);
+		)->compile(state.main_stack(), scope);
+		output->value = sm.run(state);
+#else
+		stack_machine::assembler assembler;
+		if (refers_to_variables(args)) {
+			// arguments can name globals, and then have to be compiled along with them.
+			stack_machine::stack code;
+			stack_machine::scope scope;
+			std::make_shared<where_expr>(
+				impl_->globals(),
+				std::make_shared<func_call_expr>(impl_->tableau(), args)
+			)->compile(code, scope);
+			output->value = sm.run(state, assembler.assemble(code.pop_all()));
+		} else {
+			auto compiled = impl_->compiled();
+			auto tableau = sm.run(state, compiled.program);
+			stack_machine::scope scope(compiled.lambdas);
+			stack_machine::stack call;
+			compile_tableau_call(call, tableau, args, scope);
+			output->value = sm.run(state, assembler.assemble(call.pop_all()));
+		}
+#endif
+		memos.save();
+		impl_->set_memo_stats(memos.stats());
 
 		return extract_tiles(output);
 	} catch (const tess::error& e) {
@@ -92,6 +151,21 @@ tess::result tess::script::execute(const std::vector<std::string>& arg_strings)
 	}
 }
 
+void tess::script::set_memo_file(const std::string& path) const
+{
+	impl_->set_memo_store(std::make_shared<memo_store>(path, impl_->fingerprint()));
+}
+
+tess::memo_stats tess::script::memo_statistics() const
+{
+	return impl_->memo_stats();
+}
+
+void tess::script::set_parallel(bool parallel) const
+{
+	impl_->set_parallel(parallel);
+}
+
 tess::script::script(std::shared_ptr<impl_type>  impl) : impl_(std::move(impl))
 {
 }
@@ -1,8 +1,9 @@
 #include "script_impl.h"
+#include "memo_store.h"
 #include <algorithm>
 
 tess::script::impl_type::impl_type(const assignment_block& globals, const tess::expr_ptr& tableau) :
-    globals_(globals.simplify()), tableau_(tableau->simplify())
+    globals_(globals.simplify()), tableau_(tableau->simplify()), fingerprint_(0), parallel_(false)
 {
 }
 
@@ -23,8 +24,62 @@ tess::expr_ptr tess::script::impl_type::tableau() const {
     return tableau_;
 }
 
-tess::execution_state& tess::script::impl_type::state()
+tess::script::impl_type::compiled_tableau tess::script::impl_type::compiled()
 {
-    return state_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!compiled_.program) {
+        stack_machine::stack code;
+        stack_machine::scope scope;
+        std::make_shared<where_expr>(globals_, tableau_)->compile(code, scope);
+        stack_machine::assembler assembler;
+        auto program = assembler.assemble(code.pop_all());
+        compiled_ = { program, scope.lambdas_compiled() };
+    }
+    return compiled_;
 }
 
+void tess::script::impl_type::set_fingerprint(uint64_t fingerprint)
+{
+    fingerprint_ = fingerprint;
+}
+
+uint64_t tess::script::impl_type::fingerprint() const
+{
+    return fingerprint_;
+}
+
+void tess::script::impl_type::set_memo_store(std::shared_ptr<tess::memo_store> store)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    memo_store_ = std::move(store);
+}
+
+std::shared_ptr<tess::memo_store> tess::script::impl_type::memo_store() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memo_store_;
+}
+
+void tess::script::impl_type::set_memo_stats(const tess::memo_stats& stats)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    memo_stats_ = stats;
+}
+
+tess::memo_stats tess::script::impl_type::memo_stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memo_stats_;
+}
+
+void tess::script::impl_type::set_parallel(bool parallel)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    parallel_ = parallel;
+}
+
+bool tess::script::impl_type::parallel() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return parallel_;
+}
@@ -1,26 +1,59 @@
+#pragma once
+
 #include "tessera/script.h"
 #include "tessera_impl.h"
 #include "where_expr.h"
 #include "function_def.h"
 #include "expression.h"
 #include "value.h"
-#include "execution_state.h"
+#include "bytecode.h"
 #include <vector>
 #include <unordered_map>
+#include <cstdint>
+#include <mutex>
 
 namespace tess {
 
+    class memo_store;
+
     class script::impl_type {
+        public:
+            struct compiled_tableau {
+                std::shared_ptr<const stack_machine::program> program;
+                // the number of lambdas the program numbered, see stack_machine::scope.
+                unsigned int lambdas = 0;
+            };
+
         private:
             assignment_block globals_;
             expr_ptr tableau_;
-            execution_state state_;
+            uint64_t fingerprint_;
+            compiled_tableau compiled_;
+            std::shared_ptr<tess::memo_store> memo_store_;
+            tess::memo_stats memo_stats_;
+            bool parallel_;
+            mutable std::mutex mutex_;
+
         public:
             impl_type(const assignment_block& globals, const expr_ptr& tableau);
             const std::vector<std::string>& parameters() const;
+            // of the source the script was parsed from, see memo_store.
+            void set_fingerprint(uint64_t fingerprint);
+            uint64_t fingerprint() const;
             const assignment_block& globals() const;
-            execution_state& state();
             expr_ptr tableau() const;
+
+            // a program evaluating the globals and then the tableau function, giving the lambda
+            // an execution calls with its arguments. Compiled by the first execution to ask for
+            // it; executions share the program and each run it on a state of its own.
+            compiled_tableau compiled();
+
+            void set_memo_store(std::shared_ptr<tess::memo_store> store);
+            std::shared_ptr<tess::memo_store> memo_store() const;
+            void set_memo_stats(const tess::memo_stats& stats);
+            tess::memo_stats memo_stats() const;
+            void set_parallel(bool parallel);
+            bool parallel() const;
     };
 
-}
\ No newline at end of file
+}
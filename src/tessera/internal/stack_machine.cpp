@@ -1,4 +1,5 @@
 #include "stack_machine.h"
+#include "bytecode.h"
 #include "tessera/error.h"
 #include "variant_util.h"
 #include "evaluation_context.h"
@@ -82,21 +83,28 @@ void tess::stack_machine::op_0::execute(tess::stack_machine::stack& main_stack,
 {
     if (number_of_args_ > operand_stack.count())
         throw tess::error("operand stack underflow.");
-    execute(operand_stack.pop(number_of_args_), contexts);
+    execute(operand_stack.top(number_of_args_), contexts);
+    operand_stack.drop(number_of_args_);
 }
 
 void tess::stack_machine::op_1::execute(tess::stack_machine::stack& main_stack, tess::stack_machine::stack& operand_stack, tess::context_stack& contexts)
 {
     if (number_of_args_ > operand_stack.count())
         throw tess::error("operand stack underflow.");
-    main_stack.push(execute(operand_stack.pop(number_of_args_), contexts));
+    // the result is an operand; it goes straight to the operand stack rather than 
+    // through the main stack.
+    auto result = execute(operand_stack.top(number_of_args_), contexts);
+    operand_stack.drop(number_of_args_);
+    operand_stack.push(result);
 }
 
 void tess::stack_machine::op_multi::execute(tess::stack_machine::stack& main_stack, tess::stack_machine::stack& operand_stack, tess::context_stack& contexts)
 {
     if (number_of_args_ > operand_stack.count())
         throw tess::error("operand stack underflow.");
-    main_stack.push(execute(operand_stack.pop(number_of_args_), contexts));
+    auto results = execute(operand_stack.top(number_of_args_), contexts);
+    operand_stack.drop(number_of_args_);
+    main_stack.push(results);
 }
 
 
@@ -117,10 +125,10 @@ void tess::stack_machine::stack::push(const std::vector<item>& items)
     push(items.rbegin(), items.rend());
 }
 
-void tess::stack_machine::stack::compile_and_push(const std::vector<tess::expr_ptr>& exprs)
+void tess::stack_machine::stack::compile_and_push(const std::vector<tess::expr_ptr>& exprs, scope& scope)
 {
     for (auto expr_iter = exprs.rbegin(); expr_iter != exprs.rend(); ++expr_iter)
-        (*expr_iter)->compile(*this);
+        (*expr_iter)->compile(*this, scope);
 }
 
 std::vector<tess::stack_machine::item> tess::stack_machine::stack::pop(int n)
@@ -131,6 +139,16 @@ std::vector<tess::stack_machine::item> tess::stack_machine::stack::pop(int n)
     return output;
 }
 
+tess::stack_machine::operand_view<tess::stack_machine::item> tess::stack_machine::stack::top(int n) const
+{
+    return { impl_.data() + impl_.size(), n };
+}
+
+void tess::stack_machine::stack::drop(int n)
+{
+    impl_.resize(impl_.size() - n);
+}
+
 
 bool tess::stack_machine::stack::empty() const
 {
@@ -182,10 +200,76 @@ void tess::stack_machine::stack::get_references(std::unordered_set<tess::obj_id>
 */
 /*------------------------------------------------------------------------------*/
 
-tess::stack_machine::machine::machine()
+tess::stack_machine::scope::scope(unsigned int lambdas_compiled) :
+    lambdas_(std::make_shared<unsigned int>(lambdas_compiled))
+{
+}
+
+void tess::stack_machine::scope::push_frame()
 {
+    frames_.emplace_back();
 }
 
+void tess::stack_machine::scope::pop_frame()
+{
+    frames_.pop_back();
+}
+
+int tess::stack_machine::scope::declare(const std::string& var)
+{
+    auto& frame = frames_.back();
+    auto iter = std::find(frame.begin(), frame.end(), var);
+    if (iter != frame.end())
+        return static_cast<int>(iter - frame.begin());
+    frame.push_back(var);
+    return static_cast<int>(frame.size() - 1);
+}
+
+tess::stack_machine::variable tess::stack_machine::scope::resolve(const std::string& var) const
+{
+    int depth = 0;
+    for (auto frame = frames_.rbegin(); frame != frames_.rend(); ++frame, ++depth) {
+        auto iter = std::find(frame->begin(), frame->end(), var);
+        if (iter != frame->end())
+            return variable(var, depth, static_cast<int>(iter - frame->begin()));
+    }
+    return variable(var);
+}
+
+std::vector<tess::stack_machine::variable> tess::stack_machine::scope::visible() const
+{
+    std::vector<variable> vars;
+    int depth = 0;
+    for (auto frame = frames_.rbegin(); frame != frames_.rend(); ++frame, ++depth)
+        for (int slot = 0; slot < static_cast<int>(frame->size()); ++slot)
+            vars.emplace_back((*frame)[slot], depth, slot);
+    return vars;
+}
+
+int tess::stack_machine::scope::frame_size() const
+{
+    return static_cast<int>(frames_.back().size());
+}
+
+tess::stack_machine::scope tess::stack_machine::scope::nested() const
+{
+    scope body;
+    body.lambdas_ = lambdas_;
+    return body;
+}
+
+unsigned int tess::stack_machine::scope::next_lambda_id()
+{
+    return ++*lambdas_;
+}
+
+unsigned int tess::stack_machine::scope::lambdas_compiled() const
+{
+    return *lambdas_;
+}
+
+/*------------------------------------------------------------------------------*/
+
 tess::value_ tess::stack_machine::machine::run(execution_state& state)
 {
     auto& contexts = state.context_stack();
@@ -10,6 +10,8 @@
 #include <variant>
 #include <optional>
 #include <algorithm>
+#include <iterator>
+#include <functional>
 #include <stack>
 
 namespace tess {
@@ -21,27 +23,71 @@ namespace tess {
     namespace stack_machine
     {
         class op;
+        class assembler;
         using op_ptr = std::shared_ptr<op>;
 
+        // a variable resolved at compile time to a slot in one of the frames of the
+        // current evaluation context, depth 0 being the innermost frame.
         struct variable {
         private:
             std::string name_;
+            int depth_;
+            int slot_;
         public:
-            variable(std::string str = "") : name_(str) {}
-
-            variable(int i) : name_(std::to_string(i)) {}
+            variable(std::string str = "", int depth = -1, int slot = -1) : 
+                name_(str), depth_(depth), slot_(slot) 
+            {}
 
             std::string to_string() const {
                 return  std::string("$(") + name_ + ")";
             };
 
-            std::string name() const {
+            const std::string& name() const {
                 return name_;
             }
+
+            bool is_resolved() const {
+                return slot_ >= 0;
+            }
+
+            int depth() const {
+                return depth_;
+            }
+
+            int slot() const {
+                return slot_;
+            }
+        };
+
+        // the compile-time image of the frames an evaluation context will hold when
+        // the code being compiled runs. Names are declared in the order in which
+        // they will be assigned so that resolving a name finds the same definition 
+        // that looking it up by name at runtime would have found.
+        class scope {
+        public:
+            // lambdas_compiled: the number of lambdas already numbered by the code this
+            // scope's code will run with.
+            explicit scope(unsigned int lambdas_compiled = 0);
+            void push_frame();
+            void pop_frame();
+            int declare(const std::string& var);
+            variable resolve(const std::string& var) const;
+            std::vector<variable> visible() const;
+            int frame_size() const;
+
+            // an empty scope for a function body, numbering its lambdas along with this one.
+            scope nested() const;
+            // the id of the next lambda compiled. Lambdas are numbered in the order they are
+            // compiled, which is fixed by the source, so ids are the same from run to run.
+            unsigned int next_lambda_id();
+            unsigned int lambdas_compiled() const;
+        private:
+            std::vector<std::vector<std::string>> frames_;
+            std::shared_ptr<unsigned int> lambdas_;
         };
 
         namespace detail {
-            using item_variant = std::variant<op_ptr, value_, error, variable>;
+            using item_variant = std::variant<op_ptr, value_, error>;
         }
 
 
@@ -63,6 +109,51 @@ namespace tess {
 
         //void get_references(item v, std::unordered_set<obj_id>& alloc_set);
 
+        // the top n entries of an operand stack, read in place. Indexed top first, 
+        // like the vector stack::pop(n) returns, and only valid until the stack changes.
+        template <typename T>
+        class operand_view {
+        public:
+            using iterator = std::reverse_iterator<const T*>;
+
+            operand_view(const T* end, int n) : end_(end), n_(n) {}
+
+            const T& operator[](int i) const {
+                return end_[-1 - i];
+            }
+
+            const T& front() const {
+                return end_[-1];
+            }
+
+            const T& back() const {
+                return end_[-n_];
+            }
+
+            int size() const {
+                return n_;
+            }
+
+            bool empty() const {
+                return n_ == 0;
+            }
+
+            iterator begin() const {
+                return iterator(end_);
+            }
+
+            iterator end() const {
+                return iterator(end_ - n_);
+            }
+
+        private:
+            const T* end_;
+            int n_;
+        };
+
+        using args_view = operand_view<value_>;
+        using native_func = std::function<value_(gc_heap& a, args_view args)>;
+
         class stack {
         public:
             item pop();
@@ -80,9 +171,11 @@ namespace tess {
             }
 
             void push(const std::vector<item>& item);
-            void compile_and_push(const std::vector<std::shared_ptr<expression>>& exprs);
+            void compile_and_push(const std::vector<std::shared_ptr<expression>>& exprs, scope& scope);
 
             std::vector<item> pop(int n);
+            operand_view<item> top(int n) const;
+            void drop(int n);
             bool empty() const;
             int count() const;
 
@@ -103,12 +196,13 @@ namespace tess {
                 op(int n) : number_of_args_(n) {}
                 virtual void execute(stack& main_stack, stack& operand_stack, context_stack& contexts) = 0;
                 virtual std::string to_string() const = 0;
+                virtual void emit(assembler& a) const = 0;
                 //virtual void get_references(std::unordered_set<tess::obj_id>& objects) const = 0;
         };
 
         class op_0 : public op {
         protected:
-            virtual void execute(const std::vector<item>& operands, context_stack& contexts) const = 0;
+            virtual void execute(operand_view<item> operands, context_stack& contexts) const = 0;
         public:
             op_0(int n) : op(n) {}
             void execute(stack& main_stack, stack& operand_stack, context_stack& contexts);
@@ -116,7 +210,7 @@ namespace tess {
 
         class op_1 : public op{
         protected:
-            virtual item execute(const std::vector<item>& operands, context_stack& contexts) const = 0;
+            virtual item execute(operand_view<item> operands, context_stack& contexts) const = 0;
         public:
             op_1(int n) : op(n) {}
             void execute(stack& main_stack, stack& operand_stack, context_stack& contexts);
@@ -124,17 +218,10 @@ namespace tess {
 
         class op_multi : public op {
         protected:
-            virtual std::vector<item> execute(const std::vector<item>& operands, context_stack& contexts) const = 0;
+            virtual std::vector<item> execute(operand_view<item> operands, context_stack& contexts) const = 0;
         public:
             op_multi(int n) : op(n) {}
             void execute(stack& main_stack, stack& operand_stack, context_stack& contexts);
         };
-
-        class machine
-        {
-        public:
-            machine();
-            value_ run(execution_state& state);
-        };
     };
 };
\ No newline at end of file
@@ -21,6 +21,14 @@ namespace tess {
 				return obj;
 			}
 
+			template<typename T>
+			T make_tess_obj(const typename T::impl_type* impl, std::shared_ptr<const void> owner) const {
+				T obj;
+				obj.impl_ = impl;
+				obj.owner_ = std::move(owner);
+				return obj;
+			}
+
 			template<typename T>
 			T make_tess_obj(typename std::shared_ptr<typename T::impl_type> impl) const {
 				T obj;
@@ -39,6 +47,11 @@ namespace tess {
 				return make_tess_obj<U>(impl);
 			}
 
+			template<typename U>
+			U make(const typename U::impl_type* impl, std::shared_ptr<const void> owner) {
+				return make_tess_obj<U>(impl, std::move(owner));
+			}
+
 			template<typename U>
 			U make(std::shared_ptr<typename U::impl_type> impl) {
 				return  make_tess_obj<U>(impl);
@@ -53,6 +66,12 @@ namespace tess {
 		return maker.make<T>(impl);
 	}
 
+	template<typename T>
+	T make_tess_obj(const typename T::impl_type* impl, std::shared_ptr<const void> owner) {
+		detail::tess_obj_maker maker;
+		return maker.make<T>(impl, std::move(owner));
+	}
+
 	template<typename T>
 	T make_tess_obj( std::shared_ptr<typename T::impl_type> impl) {
 		detail::tess_obj_maker maker;
@@ -0,0 +1,102 @@
+#include "thread_pool.h"
+#include <atomic>
+#include <algorithm>
+#include <exception>
+
+tess::thread_pool::thread_pool(int num_threads) :
+	done_(false)
+{
+	for (int i = 0; i < num_threads; ++i)
+		workers_.emplace_back([this]() { worker_loop(); });
+}
+
+tess::thread_pool::~thread_pool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		done_ = true;
+	}
+	cond_.notify_all();
+	for (auto& worker : workers_)
+		worker.join();
+}
+
+int tess::thread_pool::size() const
+{
+	return static_cast<int>(workers_.size());
+}
+
+void tess::thread_pool::push(std::function<void()>&& task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		tasks_.push(std::move(task));
+	}
+	cond_.notify_one();
+}
+
+void tess::thread_pool::worker_loop()
+{
+	for (;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			cond_.wait(lock, [this]() { return done_ || !tasks_.empty(); });
+			if (done_ && tasks_.empty())
+				return;
+			task = std::move(tasks_.front());
+			tasks_.pop();
+		}
+		task();
+	}
+}
+
+void tess::thread_pool::parallel_for(int n, const std::function<void(int)>& func)
+{
+	if (n <= 0)
+		return;
+
+	struct shared_state {
+		std::atomic<int> next = 0;
+		std::atomic<int> remaining;
+		std::mutex mutex;
+		std::condition_variable done;
+		std::exception_ptr error;
+	};
+	auto state = std::make_shared<shared_state>();
+	state->remaining = n;
+
+	auto run = [state, n, &func]() {
+		for (int i = state->next++; i < n; i = state->next++) {
+			try {
+				func(i);
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(state->mutex);
+				if (!state->error)
+					state->error = std::current_exception();
+			}
+			if (--state->remaining == 0) {
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->done.notify_all();
+			}
+		}
+	};
+
+	// helpers that start after every index is taken return immediately, so func
+	// is never called after this returns.
+	int helpers = std::min(size(), n - 1);
+	for (int i = 0; i < helpers; ++i)
+		push(run);
+	run();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->done.wait(lock, [&state]() { return state->remaining == 0; });
+	if (state->error)
+		std::rethrow_exception(state->error);
+}
+
+tess::thread_pool& tess::thread_pool::shared()
+{
+	static thread_pool pool(std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+	return pool;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <queue>
+#include <vector>
+#include <memory>
+
+namespace tess {
+
+    // a fixed set of worker threads pulling tasks off a shared queue.
+    class thread_pool {
+    public:
+        thread_pool(int num_threads);
+        ~thread_pool();
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        int size() const;
+
+        template<typename F>
+        auto submit(F&& func) -> std::future<decltype(func())> {
+            using result_type = decltype(func());
+            auto task = std::make_shared<std::packaged_task<result_type()>>(std::forward<F>(func));
+            auto result = task->get_future();
+            push([task]() { (*task)(); });
+            return result;
+        }
+
+        // calls func(i) for i in [0, n) and waits for all of the calls to finish. The
+        // calling thread takes indices too, so this is safe to call from a worker.
+        void parallel_for(int n, const std::function<void(int)>& func);
+
+        // the pool shared by the library, sized to the hardware.
+        static thread_pool& shared();
+
+    private:
+        void push(std::function<void()>&& task);
+        void worker_loop();
+
+        std::vector<std::thread> workers_;
+        std::queue<std::function<void()>> tasks_;
+        std::mutex mutex_;
+        std::condition_variable cond_;
+        bool done_;
+    };
+
+}
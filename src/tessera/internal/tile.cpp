@@ -11,9 +11,9 @@ std::vector<tess::vertex> tess::tile::vertices() const
 	auto sz = impl_->end_vertices() - impl_->begin_vertices();
 	std::vector<tess::vertex> wrapped_vertices(sz);
 	std::transform(impl_->begin_vertices(), impl_->end_vertices(), wrapped_vertices.begin(),
-		[]( auto& v) -> tess::vertex { 
+		[this]( auto& v) -> tess::vertex { 
 			auto ptr = to_root_ptr(v);
-			return tess::make_tess_obj<tess::vertex>(ptr.get()); 
+			return tess::make_tess_obj<tess::vertex>(ptr.get(), owner_); 
 		}
 	);
 	return wrapped_vertices;
@@ -24,9 +24,9 @@ std::vector<tess::edge> tess::tile::edges() const
 	auto sz = impl_->end_edges() - impl_->begin_edges();
 	std::vector<tess::edge> wrapped_edges(sz);
 	std::transform( impl_->begin_edges(), impl_->end_edges(), wrapped_edges.begin(),
-		[]( auto& v) -> tess::edge { 
+		[this]( auto& v) -> tess::edge { 
 			auto ptr = to_root_ptr(v);
-			return tess::make_tess_obj<tess::edge>(ptr.get()); 
+			return tess::make_tess_obj<tess::edge>(ptr.get(), owner_); 
 		}
 	);
 	return wrapped_edges;
@@ -64,24 +64,24 @@ tess::property_value tess::vertex::get_property_variant(const std::string& prop)
 
 tess::edge tess::vertex::out_edge() const
 {
-	return tess::make_tess_obj<tess::edge>(impl_->out_edge().get());
+	return tess::make_tess_obj<tess::edge>(impl_->out_edge().get(), owner_);
 }
 
 tess::edge tess::vertex::in_edge() const
 {
-	return tess::make_tess_obj<tess::edge>(impl_->in_edge().get());
+	return tess::make_tess_obj<tess::edge>(impl_->in_edge().get(), owner_);
 }
 
 /*--------------------------------------------------------------------------------*/
 
 tess::vertex tess::edge::u() const
 {
-	return tess::make_tess_obj<vertex>(impl_->u().get());
+	return tess::make_tess_obj<vertex>(impl_->u().get(), owner_);
 }
 
 tess::vertex tess::edge::v() const
 {
-	return tess::make_tess_obj<vertex>(impl_->v().get());
+	return tess::make_tess_obj<vertex>(impl_->v().get(), owner_);
 }
 
 tess::property_value tess::edge::get_property_variant(const std::string& prop) const
@@ -26,7 +26,8 @@ tess::detail::tile_impl::tile_impl( ) :
 	
 }
 
-void tess::detail::tile_impl::initialize(tess::gc_heap& a, const std::vector<std::tuple<tess::number, tess::number>>& vertex_locations) {
+template<typename T>
+void tess::detail::tile_impl::initialize_vertices(tess::gc_heap& a, const std::vector<T>& vertex_locations) {
 	auto n = static_cast<int>(vertex_locations.size());
 	vertices_.resize(n);
 	edges_.resize(n);
@@ -39,6 +40,14 @@ void tess::detail::tile_impl::initialize(tess::gc_heap& a, const std::vector<std
 	}
 }
 
+void tess::detail::tile_impl::initialize(tess::gc_heap& a, const std::vector<std::tuple<tess::number, tess::number>>& vertex_locations) {
+	initialize_vertices(a, vertex_locations);
+}
+
+void tess::detail::tile_impl::initialize(tess::gc_heap& a, const std::vector<cyclotomic>& vertex_locations) {
+	initialize_vertices(a, vertex_locations);
+}
+
 tess::detail::tile_impl::const_vertex_iter tess::detail::tile_impl::begin_vertices() const {
 	return vertices_.begin();
 }
@@ -99,20 +108,20 @@ void tess::detail::tile_impl::insert_field(const std::string& var, const value_&
 void tess::detail::tile_impl::clone_to(tess::gc_heap& allocator, std::unordered_map<obj_id, std::any>& orginal_to_clone, tile_raw_ptr mutable_clone) const
 {
 	for (auto& v : vertices_) { // clone vertices
-		mutable_clone->vertices_.push_back( clone_object(self_graph_ptr(), allocator, orginal_to_clone, v) );
+		mutable_clone->vertices_.push_back( clone_object(mutable_clone->self_graph_ptr(), allocator, orginal_to_clone, v) );
 	}
 	for (auto& e : edges_) { // clone edges
-		mutable_clone->edges_.push_back( clone_object(self_graph_ptr(), allocator, orginal_to_clone, e) );
+		mutable_clone->edges_.push_back( clone_object(mutable_clone->self_graph_ptr(), allocator, orginal_to_clone, e) );
 	}
 
 	if (parent_) { // clone parent
-		mutable_clone->parent_ = clone_object(self_graph_ptr(), allocator, orginal_to_clone, parent_);
+		mutable_clone->parent_ = clone_object(mutable_clone->self_graph_ptr(), allocator, orginal_to_clone, parent_);
 	} else {
 		mutable_clone->parent_ = {};
 	}
 
 	for (const auto& [var, val] : fields_) { //clone fields
-		auto v = tess::clone_value(self_graph_ptr(), allocator, orginal_to_clone, val);
+		auto v = tess::clone_value(mutable_clone->self_graph_ptr(), allocator, orginal_to_clone, val);
 		mutable_clone->fields_[var] = std::move(v); // std::move(tess::clone_value(allocator, orginal_to_clone, val));
 	}
 }
@@ -244,10 +253,10 @@ const std::map<std::string, tess::field_value>& tess::detail::tile_impl::fields(
 	return fields_;
 }
 
-void tess::detail::tile_impl::apply(const matrix& mat)
+void tess::detail::tile_impl::apply(const matrix& mat, const std::optional<exact_transform>& exact)
 {
 	for (auto& vertex : vertices_) {
-		vertex->apply(mat);
+		vertex->apply(mat, exact);
 	}
 }
 
@@ -265,7 +274,7 @@ tess::const_tile_root_ptr tess::detail::tile_impl::flip(gc_heap& a) const
 
 void tess::detail::tile_impl::flip()
 {
-	apply(flip_matrix());
+	apply(flip_matrix(), exact_transform::flip());
 	for (auto& e : edges_) {
 		e->flip();
 	}
@@ -282,7 +291,7 @@ void tess::detail::tile_impl::set_parent(tess::patch_root_ptr parent, int index)
 void tess::detail::tile_impl::detach()
 {
 	for (auto& v : vertices_)
-		v->set_location(v->pos());
+		v->set_location(v->pos(), v->exact_pos());
 	parent_ = {};
 	index_ = -1;
 }
@@ -438,12 +447,12 @@ void  tess::detail::edge_impl::clone_to(tess::gc_heap& allocator, std::unordered
 	mutable_clone->v_ = v_;
 
 	if (parent_)
-	    mutable_clone->parent_ = clone_object(self_graph_ptr(), allocator, orginal_to_clone, parent_); // clone parent
+	    mutable_clone->parent_ = clone_object(mutable_clone->self_graph_ptr(), allocator, orginal_to_clone, parent_); // clone parent
 	else
 		mutable_clone->parent_ = {};
 
 	for (const auto& [var, val] : fields_) {
-		auto v = tess::clone_value(self_graph_ptr(), allocator, orginal_to_clone, val);
+		auto v = tess::clone_value(mutable_clone->self_graph_ptr(), allocator, orginal_to_clone, val);
 		mutable_clone->fields_[var] = std::move(v); // clone fields
 	}
 }
@@ -455,6 +464,15 @@ void tess::detail::vertex_impl::initialize( gc_heap& a, int n, std::tuple<number
 	parent_ = {};
 	index_ = n;
 	location_ = loc;
+	exact_location_ = std::nullopt;
+}
+
+void tess::detail::vertex_impl::initialize(gc_heap& a, int n, const cyclotomic& loc)
+{
+	parent_ = {};
+	index_ = n;
+	location_ = loc.to_point();
+	exact_location_ = loc;
 }
 
 void tess::detail::vertex_impl::set_parent(tile_root_ptr parent)
@@ -489,6 +507,17 @@ tess::point tess::detail::vertex_impl::pos() const
 	);
 }
 
+std::optional<tess::cyclotomic> tess::detail::vertex_impl::exact_pos() const
+{
+	if (std::holds_alternative<point>(location_))
+		return exact_location_;
+
+	auto patch = this->grandparent();
+	if (!patch)
+		throw error("corrupt tile patch");
+	return patch->get_exact_vertex_location(std::get<int>(location_));
+}
+
 tess::value_ tess::detail::vertex_impl::get_field(gc_heap& allocator, const std::string& field) const
 {
 	return {}; //TODO
@@ -499,8 +528,9 @@ void tess::detail::vertex_impl::clone_to(tess::gc_heap& allocator, std::unordere
 {
 	mutable_clone->index_ = index_;
 	mutable_clone->location_ = location_;
+	mutable_clone->exact_location_ = exact_location_;
 	if (parent_) {
-		mutable_clone->parent_ = clone_object(self_graph_ptr(), allocator, orginal_to_clone, parent_); // parent
+		mutable_clone->parent_ = clone_object(mutable_clone->self_graph_ptr(), allocator, orginal_to_clone, parent_); // parent
 	} else {
 		mutable_clone->parent_ = {};
 	}
@@ -516,11 +546,13 @@ tess::const_patch_root_ptr tess::detail::vertex_impl::grandparent() const
 void tess::detail::vertex_impl::set_location(int n)
 {
 	location_ = n;
+	exact_location_ = std::nullopt;
 }
 
-void tess::detail::vertex_impl::set_location(point pt)
+void tess::detail::vertex_impl::set_location(point pt, const std::optional<cyclotomic>& exact_pt)
 {
 	location_ = pt;
+	exact_location_ = exact_pt;
 }
 
 int tess::detail::vertex_impl::location_index() const
@@ -536,10 +568,19 @@ std::string  tess::detail::vertex_impl::debug() const
 	return ss.str();
 }
 
-void tess::detail::vertex_impl::apply(const tess::matrix& mat) {
+void tess::detail::vertex_impl::apply(const tess::matrix& mat, const std::optional<exact_transform>& exact) {
 
 	if (std::holds_alternative<point>(location_)) {
+		if (exact_location_ && exact) {
+			try {
+				exact_location_ = exact->apply(*exact_location_);
+				location_ = exact_location_->to_point();
+				return;
+			} catch (const cyclotomic_overflow&) {
+			}
+		}
 		location_ = apply_matrix(mat, std::get<point>(location_));
+		exact_location_ = std::nullopt;
 	} else {
 		throw error("vertex::impl_type::apply called on patch vertex");
 	}
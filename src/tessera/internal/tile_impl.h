@@ -6,6 +6,7 @@
 #include "value.h"
 #include "number.h"
 #include "geometry.h"
+#include "cyclotomic.h"
 #include <string>
 #include <vector>
 #include <tuple>
@@ -22,15 +23,18 @@ namespace tess {
                 tile_graph_ptr parent_;
                 int index_;
                 std::variant<int, point> location_;
+                std::optional<cyclotomic> exact_location_;
 
             public:
                 vertex_impl() : index_(-1), location_(-1) {};
                 void initialize(gc_heap& a, int index, point loc);
+                void initialize(gc_heap& a, int index, const cyclotomic& loc);
                 void set_parent(tile_root_ptr parent);
                 std::tuple<double, double> to_floats() const;
                 point pos() const;
+                std::optional<cyclotomic> exact_pos() const;
                 value_ get_field(gc_heap& allocator, const std::string& field) const;
-                void apply(const matrix& mat);
+                void apply(const matrix& mat, const std::optional<exact_transform>& exact = std::nullopt);
                 const_tile_root_ptr parent() const;
                 const_edge_root_ptr in_edge() const;
                 const_edge_root_ptr out_edge() const;
@@ -38,7 +42,7 @@ namespace tess {
                 void clone_to(tess::gc_heap& allocator, std::unordered_map<obj_id, std::any>& orginal_to_clone, vertex_raw_ptr clone) const;
                 const_patch_root_ptr grandparent() const;
                 void set_location(int vert_index);
-                void set_location(point pt);
+                void set_location(point pt, const std::optional<cyclotomic>& exact_pt = std::nullopt);
                 int location_index() const;
                 std::string debug() const;
         };
@@ -83,10 +87,14 @@ namespace tess {
                 patch_graph_ptr parent_;
                 int index_;
 
+                template<typename T>
+                void initialize_vertices(tess::gc_heap& allocator, const std::vector<T>& vertex_locations);
+
             public:
 
                 tile_impl();
                 void initialize(tess::gc_heap& allocator, const std::vector<std::tuple<tess::number, tess::number>>& vertex_locations);
+                void initialize(tess::gc_heap& allocator, const std::vector<cyclotomic>& vertex_locations);
 
                 using const_edge_iter = std::vector<tess::edge_graph_ptr>::const_iterator;
                 using edge_iter = std::vector<tess::edge_graph_ptr>::iterator;
@@ -112,7 +120,7 @@ namespace tess {
                 value_ get_field(const std::string& field) const;
                 value_ get_field(gc_heap& allocator, const std::string& field) const;
                 const std::map<std::string, field_value>& fields() const;
-                void apply(const matrix& mat);
+                void apply(const matrix& mat, const std::optional<exact_transform>& exact = std::nullopt);
                 tess::const_tile_root_ptr flip(gc_heap& a) const;
                 void flip();
                 bool has_parent() const;
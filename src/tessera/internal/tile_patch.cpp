@@ -8,8 +8,8 @@ std::vector<tess::tile> tess::tile_patch::tiles() const
 	auto sz = count();
 	std::vector<tess::tile> wrapped_tiles( sz );
 	std::transform(impl_->begin_tiles(), impl_->end_tiles(), wrapped_tiles.begin(),
-		[](auto& v) -> tess::tile { 
-			return tess::make_tess_obj<tess::tile>(to_root_ptr(v).get()); 
+		[this](auto& v) -> tess::tile { 
+			return tess::make_tess_obj<tess::tile>(to_root_ptr(v).get(), owner_); 
 		}
 	);
 	return wrapped_tiles;
@@ -69,8 +69,8 @@ namespace {
 		tess::edge_table<tess::tile_root_ptr> edge_tbl;
 		std::vector<std::tuple<tess::tile_root_ptr, tess::tile_root_ptr>> output;
 		for ( auto& e : broken_edges) {
-			auto u = vert_tbl.insert(e->u()->pos());
-			auto v = vert_tbl.insert(e->v()->pos());
+			auto u = vert_tbl.insert(e->u()->pos(), e->u()->exact_pos());
+			auto v = vert_tbl.insert(e->v()->pos(), e->v()->exact_pos());
 			if (edge_tbl.find({ u,v }) != edge_tbl.end())
 				throw tess::error("invalid tile patch while flattening (unable to auto join broekn tiles)");
 			edge_tbl[{ u, v }] = e->parent();
@@ -159,7 +159,7 @@ namespace {
 		std::transform(grouped_tiles.begin(), grouped_tiles.end(), output.begin(),
 			[&a]( auto& tile_group)->tess::tile_root_ptr {
 				if (tile_group.size() == 1) {
-					return tess::clone_object(a, to_const(tile_group.front()) );
+					return tile_group.front(); // flatten already copied or adopted it
 				} else {
 					return tess::join(a, tile_group);
 				}
@@ -171,13 +171,14 @@ namespace {
 
 	void propagate_edge_fields(tess::tile_root_ptr tile, tess::const_patch_root_ptr patch)
 	{
-		tess::edge_location_table edges;
+		std::vector<tess::const_edge_root_ptr> patch_edges;
 		for (auto j = patch->begin_tiles(); j != patch->end_tiles(); ++j) {
 			auto& tile = *j;
 			for (auto i = tile->begin_edges(); i != tile->end_edges(); ++i) {
-				edges.insert( to_const(to_root_ptr(*i)) );
+				patch_edges.push_back( to_const(to_root_ptr(*i)) );
 			}
 		}
+		tess::edge_location_table edges(patch_edges);
 
 		for (auto iter = tile->begin_edges(); iter != tile->end_edges(); ++iter) {
 			auto edge = to_root_ptr(*iter);
@@ -259,8 +260,7 @@ void tess::detail::patch_impl::build_edge_table() const
 }
 
 void tess::detail::patch_impl::initialize( tess::gc_heap& a, const std::vector<tess::tile_root_ptr>& tiles) {
-	for ( auto& t : tiles)
-		insert_tile(t);
+	insert_tiles(tiles);
 }
 
 void tess::detail::patch_impl::insert_tile( tess::tile_root_ptr tile )
@@ -269,7 +269,7 @@ void tess::detail::patch_impl::insert_tile( tess::tile_root_ptr tile )
 
 	for (auto iter = tile->begin_vertices(); iter != tile->end_vertices(); ++iter) {
 		auto& vert = *iter;
-		int new_vert_index = vert_tbl_.insert(vert->pos());
+		int new_vert_index = vert_tbl_.insert(vert->pos(), vert->exact_pos());
 		vert->set_location( new_vert_index );
 	}
 
@@ -278,6 +278,29 @@ void tess::detail::patch_impl::insert_tile( tess::tile_root_ptr tile )
 	);
 }
 
+void tess::detail::patch_impl::insert_tiles(const std::vector<tess::tile_root_ptr>& tiles)
+{
+	std::vector<tess::point> pts;
+	std::vector<std::optional<cyclotomic>> exact_pts;
+	for (const auto& tile : tiles) {
+		for (auto iter = tile->begin_vertices(); iter != tile->end_vertices(); ++iter) {
+			pts.push_back((*iter)->pos());
+			exact_pts.push_back((*iter)->exact_pos());
+		}
+	}
+	auto indices = vert_tbl_.insert(pts, exact_pts);
+
+	int i = 0;
+	for (const auto& tile : tiles) {
+		tile->set_parent(to_root_ptr(self_graph_ptr()), static_cast<int>(tiles_.size()));
+		for (auto iter = tile->begin_vertices(); iter != tile->end_vertices(); ++iter)
+			(*iter)->set_location(indices[i++]);
+		tiles_.push_back(
+			tile_graph_ptr(self_graph_ptr(), tile)
+		);
+	}
+}
+
 int tess::detail::patch_impl::count() const
 {
 	return static_cast<int>(tiles_.size());
@@ -299,6 +322,11 @@ tess::value_ tess::detail::patch_impl::get_field(gc_heap& allocator, const std::
 	return from_field_value(iter->second);
 }
 
+const std::map<std::string, tess::field_value>& tess::detail::patch_impl::fields() const
+{
+	return fields_;
+}
+
 tess::value_ tess::detail::patch_impl::get_ary_item(int i) const
 {
 	return tess::make_value(to_root_ptr(tiles_.at(i)));
@@ -309,9 +337,9 @@ int tess::detail::patch_impl::get_ary_count() const
 	return static_cast<int>(tiles_.size());
 }
 
-void tess::detail::patch_impl::apply(const matrix& mat)
+void tess::detail::patch_impl::apply(const matrix& mat, const std::optional<exact_transform>& exact)
 { 
-	vert_tbl_.apply_transformation(mat);
+	vert_tbl_.apply_transformation(mat, exact);
 }
 
 std::string tess::detail::patch_impl::debug() const
@@ -333,7 +361,7 @@ tess::patch_root_ptr tess::detail::patch_impl::flip(gc_heap& a) const {
 }
 
 void  tess::detail::patch_impl::flip()  {
-	apply(flip_matrix());
+	apply(flip_matrix(), exact_transform::flip());
 	for (auto& tile : tiles_) {
 		for (auto iter = tile->begin_edges(); iter != tile->end_edges(); ++iter) {
 			auto& e = *iter;
@@ -355,9 +383,9 @@ tess::const_edge_root_ptr tess::detail::patch_impl::get_edge_on(int u, int v) co
 		return {};
 }
 
-tess::const_edge_root_ptr tess::detail::patch_impl::get_edge_on(tess::point u, tess::point v) const {
-	auto u_index = vert_tbl_.get_index(u);
-	auto v_index = vert_tbl_.get_index(v);
+tess::const_edge_root_ptr tess::detail::patch_impl::get_edge_on(tess::const_vertex_root_ptr u, tess::const_vertex_root_ptr v) const {
+	auto u_index = vert_tbl_.get_index(u->pos(), u->exact_pos());
+	auto v_index = vert_tbl_.get_index(v->pos(), v->exact_pos());
 	return get_edge_on(u_index, v_index);
 }
 
@@ -366,7 +394,7 @@ tess::value_ tess::detail::patch_impl::get_on(gc_heap& a, const std::variant<tes
 	return std::visit(
 		overloaded{
 			[&](tess::const_edge_root_ptr e) -> value_ {
-				auto maybe_edge = get_edge_on( e->u()->pos(), e->v()->pos());
+				auto maybe_edge = get_edge_on( e->u(), e->v());
 				if (maybe_edge) {
 					return value_(maybe_edge);
 				} else {
@@ -392,11 +420,11 @@ void tess::detail::patch_impl::clone_to(tess::gc_heap& a, std::unordered_map<obj
 {
 	for (const auto& t : tiles_) { // clone tiles
 		mutable_clone->tiles_.push_back( 
-			clone_object( self_graph_ptr(), a, orginal_to_clone, t )
+			clone_object( mutable_clone->self_graph_ptr(), a, orginal_to_clone, t )
 		);
 	}
 	for (const auto& [var, val] : fields_) { // clone fields
-		mutable_clone->fields_[var] = tess::clone_value(self_graph_ptr(), a, orginal_to_clone, val);
+		mutable_clone->fields_[var] = tess::clone_value(mutable_clone->self_graph_ptr(), a, orginal_to_clone, val);
 	}
 	mutable_clone->vert_tbl_ = vert_tbl_;
 }
@@ -405,11 +433,36 @@ tess::point tess::detail::patch_impl::get_vertex_location(int index) const {
 	return vert_tbl_.get_location(index);
 }
 
+std::optional<tess::cyclotomic> tess::detail::patch_impl::get_exact_vertex_location(int index) const {
+	return vert_tbl_.get_exact_location(index);
+}
+
+std::optional<std::vector<tess::cyclotomic>> tess::detail::patch_impl::get_exact_locations(const std::vector<point>& points) const
+{
+	// the joined outline is made of vertices of this patch so it can keep their exact locations
+	std::vector<tess::cyclotomic> exact_points;
+	exact_points.reserve(points.size());
+	try {
+		for (const auto& pt : points) {
+			auto exact_pt = vert_tbl_.get_exact_location(vert_tbl_.get_index(pt));
+			if (!exact_pt.has_value())
+				return std::nullopt;
+			exact_points.push_back(*exact_pt);
+		}
+	} catch (const tess::error&) {
+		return std::nullopt;
+	}
+	return exact_points;
+}
+
 tess::tile_root_ptr tess::detail::patch_impl::join(tess::gc_heap& a) const
 {
 	auto self_ptr = to_const(to_root_ptr( self_graph_ptr() ));
 	auto points = tess::join(self_ptr);
-	auto joined_patch = a.make_mutable<tess::const_tile_root_ptr>(points);
+	auto exact_points = get_exact_locations(points);
+	auto joined_patch = (exact_points.has_value()) ?
+		a.make_mutable<tess::const_tile_root_ptr>(*exact_points) :
+		a.make_mutable<tess::const_tile_root_ptr>(points);
 	propagate_fields(joined_patch, self_ptr);
 	return joined_patch;
 }
@@ -477,7 +530,7 @@ void tess::detail::cluster_impl::clone_to(tess::gc_heap& allocator, std::unorder
 {
 	for (const auto& value : values_) {
 		mutable_clone->values_.push_back(
-			tess::clone_value(self_graph_ptr(), allocator, orginal_to_clone, value)
+			tess::clone_value(mutable_clone->self_graph_ptr(), allocator, orginal_to_clone, value)
 		); // items
 	}
 }
@@ -506,7 +559,7 @@ int count_tiles(const std::vector<tess::value_>& tiles_and_patches) {
 	return count;
 }
 
-tess::patch_root_ptr tess::flatten(tess::gc_heap& a, const std::vector<tess::value_>& tiles_and_patches, bool should_join_broken_tiles) {
+tess::patch_root_ptr tess::flatten(tess::gc_heap& a, const std::vector<tess::value_>& tiles_and_patches, bool should_join_broken_tiles, bool adopt_tiles) {
 	for (const auto& v : tiles_and_patches)
 		if (!std::holds_alternative<tess::const_tile_root_ptr>(v) && !std::holds_alternative<tess::const_patch_root_ptr>(v))
 			throw tess::error("attempted to flatten a value that is not a tile or tile patch");
@@ -514,13 +567,21 @@ tess::patch_root_ptr tess::flatten(tess::gc_heap& a, const std::vector<tess::val
 	std::vector<tess::tile_root_ptr> tiles;
 	tiles.reserve(n);
 	for (const auto& tile_or_patch : tiles_and_patches) {
+		bool adopt = adopt_tiles && !tess::is_shared(tile_or_patch);
 		std::visit(
 			overloaded{
-				[&](tess::const_tile_root_ptr t) { tiles.push_back( tess::clone_object(a, t) ); },
+				[&](tess::const_tile_root_ptr t) { tiles.push_back( adopt ? from_const(t) : tess::clone_object(a, t) ); },
 				[&](tess::const_patch_root_ptr patch) {
 					for (auto i = patch->begin_tiles(); i != patch->end_tiles(); ++i) {
-						auto clone = (*i)->clone_detached(a);
-						tiles.push_back(clone);
+						if (adopt) {
+							// positions come from the patch's vertex table, so fix them before it lets go.
+							auto tile = to_root_ptr(*i);
+							tile->detach();
+							tiles.push_back(tile);
+						} else {
+							auto clone = (*i)->clone_detached(a);
+							tiles.push_back(clone);
+						}
 					}
 				},
 				[](auto) { throw tess::error("unknown error"); }
@@ -533,9 +594,7 @@ tess::patch_root_ptr tess::flatten(tess::gc_heap& a, const std::vector<tess::val
 		tiles = join_broken_tiles(a, tiles);
 
 	auto patch_impl = a.make_mutable<tess::const_patch_root_ptr>();
-	for (const auto& tile : tiles) {
-		patch_impl->insert_tile( tile );
-	}
+	patch_impl->insert_tiles(tiles);
 
 	return patch_impl;
 }
@@ -6,8 +6,8 @@
 #include "cluster.h"
 #include "tessera/tile_patch.h"
 #include "geometry.h"
+#include "cyclotomic.h"
 #include "value.h"
-#include "geometry.h"
 #include <vector>
 #include <map>
 #include <optional>
@@ -26,6 +26,7 @@ namespace tess {
             vertex_location_table vert_tbl_;
             mutable edge_table<edge_graph_ptr> edge_tbl_;
             void build_edge_table() const;
+            std::optional<std::vector<cyclotomic>> get_exact_locations(const std::vector<point>& points) const;
 
         public:
 
@@ -41,20 +42,23 @@ namespace tess {
             const_tile_iterator end_tiles() const;
 
             void insert_tile(tess::tile_root_ptr t);
+            void insert_tiles(const std::vector<tess::tile_root_ptr>& tiles);
             int count() const;
             value_ get_field(gc_heap& allocator, const std::string& field) const;
+            const std::map<std::string, field_value>& fields() const;
             value_ get_ary_item(int i) const;
             int get_ary_count() const;
-            void apply(const matrix& mat);
+            void apply(const matrix& mat, const std::optional<exact_transform>& exact = std::nullopt);
             patch_root_ptr flip(gc_heap& allocator) const;
             void flip();
             tess::const_edge_root_ptr get_edge_on(int u, int v) const;
-            tess::const_edge_root_ptr get_edge_on(tess::point u, tess::point v) const;
+            tess::const_edge_root_ptr get_edge_on(tess::const_vertex_root_ptr u, tess::const_vertex_root_ptr v) const;
             value_ get_on(gc_heap& a, const std::variant<tess::const_edge_root_ptr, tess::const_cluster_root_ptr>& e) const;
             void insert_field(const std::string& var, const value_& val);
             //void get_references(std::unordered_set<obj_id>& alloc_set) const;
             void clone_to(tess::gc_heap& allocator, std::unordered_map<obj_id, std::any>& orginal_to_clone, patch_raw_ptr clone) const;
             point get_vertex_location(int index) const;
+            std::optional<cyclotomic> get_exact_vertex_location(int index) const;
             tile_root_ptr join(gc_heap& allocator) const;
             void dfs(tile_visitor visit) const;
 
@@ -81,7 +85,10 @@ namespace tess {
 
     }
 
-    patch_root_ptr flatten(gc_heap& a, const std::vector<value_>& tiles_and_patches, bool should_join_broken_tiles);
+    // the tiles of tiles_and_patches in one new patch. The tiles are copied unless
+    // adopt_tiles is set, in which case the new patch takes over the tiles of values that
+    // are not shared; lay does this with the copies it makes of its layees.
+    patch_root_ptr flatten(gc_heap& a, const std::vector<value_>& tiles_and_patches, bool should_join_broken_tiles, bool adopt_tiles = false);
     tile_root_ptr join(gc_heap& a, const std::vector<value_>& tiles_and_patches, bool should_join_broken_tiles);
     tile_root_ptr join(gc_heap& a, const std::vector<tile_root_ptr>& tiles);
 
@@ -91,6 +91,37 @@ tess::value_ tess::clone_value( gc_heap& allocator, const value_& v)
 }
 
 
+void tess::share(const value_& v)
+{
+	if (!is_object_like(v))
+		return;
+
+	using object_variant_type = std::variant<const_tile_root_ptr, const_patch_root_ptr, const_edge_root_ptr, const_vertex_root_ptr, const_lambda_root_ptr, const_cluster_root_ptr>;
+	object_variant_type obj_variant = variant_cast(v);
+	std::visit(
+		[](const auto& obj) { graph_pool::share(obj); },
+		obj_variant
+	);
+}
+
+bool tess::is_shared(const value_& v)
+{
+	if (!is_object_like(v))
+		return false;
+
+	using object_variant_type = std::variant<const_tile_root_ptr, const_patch_root_ptr, const_edge_root_ptr, const_vertex_root_ptr, const_lambda_root_ptr, const_cluster_root_ptr>;
+	object_variant_type obj_variant = variant_cast(v);
+	return std::visit(
+		[](const auto& obj) { return graph_pool::is_shared(obj); },
+		obj_variant
+	);
+}
+
+tess::value_ tess::unshare(gc_heap& allocator, const value_& v)
+{
+	return is_shared(v) ? clone_value(allocator, v) : v;
+}
+
 tess::value_ tess::get_ary_item(value_ v, int index)
 {
 	// patches and clusters can be referenced like an array.
@@ -156,41 +187,6 @@ std::string tess::to_string(value_ v)
 	return "#(some expr value)";
 }
 
-std::string tess::serialize(tess::serialization_state& state, tess::value_ val)
-{
-	return std::visit(
-		overloaded{
-			[&state](const const_lambda_root_ptr& lambda) -> std::string {
-				return lambda->serialize(state);
-			},
-			[](nil_val v) -> std::string {
-				return "<nil>";
-			},
-			[](number n) -> std::string {
-					std::stringstream ss;
-					ss << n;
-					return ss.str();
-			},
-			[](std::string s) -> std::string {
-				return "\"" + s + "\"";
-			},
-			[](bool v) -> std::string {
-				return v ? "<true>" : "<false>";
-			},
-			[](const auto& v) {
-				return std::string();
-			}
-		},
-		val
-	);
-}
-
-std::string tess::serialize(value_ val)
-{
-	serialization_state state;
-	return serialize(state, val);
-}
-
 bool tess::operator==(const value_& lhs, const value_& rhs)
 {
 	return std::visit(
@@ -229,22 +225,3 @@ bool tess::operator==(const field_value& lhs, const field_value& rhs)
 bool tess::operator!=(const field_value& lhs, const field_value& rhs) {
 	return !(lhs == rhs);
 }
-
-tess::serialization_state::serialization_state() : current_id_(0)
-{
-}
-
-std::optional<tess::obj_id> tess::serialization_state::get_obj(tess::obj_id id) const
-{
-	auto iter = tbl_.find(id);
-	if (iter != tbl_.end())
-		return iter->second;
-	else
-		return std::nullopt;
-}
-
-tess::obj_id tess::serialization_state::insert(tess::obj_id id)
-{
-	tbl_[id] = ++current_id_;
-	return current_id_;
-}
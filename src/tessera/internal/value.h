@@ -5,6 +5,7 @@
 #include "variant_util.h"
 #include <variant>
 #include <any>
+#include <optional>
 #include <memory>
 #include <unordered_set>
 #include <unordered_map>
@@ -56,16 +57,6 @@ namespace tess {
 
 	}
 
-	class serialization_state {
-	public:
-		serialization_state();
-		std::optional<tess::obj_id> get_obj(tess::obj_id id) const;
-		tess::obj_id insert(tess::obj_id id);
-	private:
-		std::unordered_map<obj_id, tess::obj_id> tbl_;
-		tess::obj_id current_id_;
-	};
-
 	class execution_state;
 
 	class nil_val {
@@ -148,6 +139,13 @@ namespace tess {
 	value_ clone_value(gc_heap& allocator, std::unordered_map<tess::obj_id, std::any>& original_to_clone, const value_& v);
 	value_ clone_value(gc_heap& allocator, const value_& v);
 
+	// a value that can be handed out more than once, like a memoized result, is shared: 
+	// the objects reachable from it are not mutated in place again. unshare returns a 
+	// value that may be mutated, which is a deep copy if v is shared.
+	void share(const value_& v);
+	bool is_shared(const value_& v);
+	value_ unshare(gc_heap& allocator, const value_& v);
+
 	template<typename U>
 	field_value clone_value(const tess::graph_ptr<U>& u, gc_heap& a,  std::unordered_map<tess::obj_id, std::any>& original_to_clone, const field_value& v) {
 		auto root_ptr_val = from_field_value(v);
@@ -169,8 +167,6 @@ namespace tess {
 	void insert_field(value_ v, const std::string& var, value_ val);
 	std::string to_string(value_ v);
 
-	std::string serialize(value_ v);
-	std::string serialize(serialization_state& state, value_ v);
 
 	bool operator==(const value_& lhs, const value_& rhs);
 	bool operator!=(const value_& lhs, const value_& rhs);
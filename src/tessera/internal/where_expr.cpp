@@ -5,30 +5,23 @@
 
 namespace {
 
-	int num_vars_in_assignment(tess::var_assignment va) {
-		return static_cast<int>(std::get<0>(va).size() );
-	}
-
-	void compile_multi_assignment(tess::stack_machine::stack& stack, tess::var_assignment va) {
+	void compile_assignment(tess::stack_machine::stack& stack, tess::stack_machine::scope& scope, const tess::var_assignment& va) {
 		const auto& [vars, val] = va;
-		stack.push(std::make_shared<tess::assign_op>(static_cast<int>(vars.size())));
 
-		std::vector<tess::stack_machine::item> identifiers(vars.size());
-		std::transform(vars.rbegin(), vars.rend(), identifiers.begin(),
-			[](const auto& var)->tess::stack_machine::item {
-				return { tess::stack_machine::variable( var ) };
+		// the value is compiled before the variables are declared so that it sees
+		// whatever they referred to before this assignment.
+		tess::stack_machine::stack value;
+		val->compile(value, scope);
+
+		std::vector<tess::stack_machine::variable> targets(vars.size());
+		std::transform(vars.begin(), vars.end(), targets.begin(),
+			[&scope](const auto& var) {
+				return tess::stack_machine::variable(var, 0, scope.declare(var));
 			}
 		);
 
-		stack.push(identifiers);
-		val->compile(stack);
-	}
-	
-	void compile_assignment(tess::stack_machine::stack& stack, tess::var_assignment va) {
-		const auto& [vars, val] = va;
-		stack.push(std::make_shared<tess::assign_op>(1));
-		stack.push(tess::stack_machine::variable(vars[0]));
-		val->compile(stack);
+		stack.push(std::make_shared<tess::assign_op>(targets));
+		stack.push(value.pop_all());
 	}
 }
 
@@ -37,16 +30,17 @@ tess::assignment_block::assignment_block(const std::vector<var_assignment>& assi
 {
 }
 
-void tess::assignment_block::compile(stack_machine::stack& stack) const
+void tess::assignment_block::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
-	for (auto i = impl_->rbegin(); i != impl_->rend(); ++i) {
-		const auto& assignment = *i;
-		int num_vars = num_vars_in_assignment(assignment);
-		if (num_vars > 1)
-			compile_multi_assignment(stack, assignment);
-		else
-			compile_assignment(stack, assignment);
+	// compiled in the order the assignments run, then pushed in reverse.
+	std::vector<std::vector<stack_machine::item>> assignments;
+	for (const auto& assignment : *impl_) {
+		stack_machine::stack code;
+		compile_assignment(code, scope, assignment);
+		assignments.push_back(code.pop_all());
 	}
+	for (auto i = assignments.rbegin(); i != assignments.rend(); ++i)
+		stack.push(*i);
 }
 
 std::string tess::assignment_block::to_string() const
@@ -114,13 +108,18 @@ tess::where_expr::where_expr(where_expr_params params) :
 {
 }
 
-void tess::where_expr::compile(stack_machine::stack& stack) const
+void tess::where_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
+	scope.push_frame();
+	stack_machine::stack assignments;
+	assignments_.compile(assignments, scope);
+
 	stack.push(std::make_shared<pop_frame_op>());
-	body_->compile(stack);
-	stack.push(std::make_shared<set_dependencies_op>());
-	assignments_.compile(stack);
-	stack.push(std::make_shared<push_frame_op>());
+	body_->compile(stack, scope);
+	stack.push(std::make_shared<set_dependencies_op>(scope.visible()));
+	stack.push(assignments.pop_all());
+	stack.push(std::make_shared<push_frame_op>(scope.frame_size()));
+	scope.pop_frame();
 }
 
 std::string tess::where_expr::to_string() const
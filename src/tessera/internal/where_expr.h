@@ -16,7 +16,7 @@ namespace tess {
 		public:
 			assignment_block() {}
 			assignment_block(const std::vector<var_assignment>& assignments);
-			void compile(stack_machine::stack& stack) const;
+			void compile(stack_machine::stack& stack, stack_machine::scope& scope) const;
 			std::string to_string() const;
 			bool operator!=(const assignment_block& block) { return impl_.get() != block.impl_.get(); }
 			assignment_block simplify() const;
@@ -37,7 +37,7 @@ namespace tess {
 	public:
 		where_expr(const assignment_block& assignments, expr_ptr body);
 		where_expr(where_expr_params params);
-		void compile(stack_machine::stack& stack) const override;
+		void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
 		std::string to_string() const override;
 		expr_ptr simplify() const override;
 		void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
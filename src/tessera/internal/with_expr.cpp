@@ -5,12 +5,12 @@
 #include "parser/keywords.h"
 
 namespace {
-    void compile_field_def(tess::stack_machine::stack& stack, tess::field_definitions::field_def_pair fd) {
+    void compile_field_def(tess::stack_machine::stack& stack, tess::stack_machine::scope& scope, tess::field_definitions::field_def_pair fd) {
         const auto& [fields, val] = fd;
         stack.push(std::make_shared<tess::set_field_op>(static_cast<int>(fields.size())));
         for (const auto& field : fields)
-            field->compile(stack);
-        val->compile(stack);
+            field->compile(stack, scope);
+        val->compile(stack, scope);
     }
 }
 
@@ -26,16 +26,29 @@ tess::with_expr::with_expr(with_expr_params params) :
 {
 }
 
-void tess::with_expr::compile(stack_machine::stack& stack) const
+void tess::with_expr::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
+    // the body runs before "this" is assigned, so it is compiled before "this" is declared.
+    scope.push_frame();
+    stack_machine::stack body;
+    body_->compile(body, scope);
+    stack_machine::variable self("this", 0, scope.declare("this"));
+
     stack.push(std::make_shared<pop_frame_op>());
-    stack.push(std::make_shared<get_var>());
-    stack.push(tess::stack_machine::variable("this"));
-    field_defs_.compile(stack);
-    stack.push(std::make_shared<tess::assign_op>(1));
-    stack.push(tess::stack_machine::variable("this"));
-    body_->compile(stack);
-    stack.push(std::make_shared<push_frame_op>());
+    stack.push(std::make_shared<get_var>(self));
+    field_defs_.compile(stack, scope);
+    stack.push(std::make_shared<tess::assign_op>(std::vector<stack_machine::variable>{ self }));
+    // the fields are set in place, so a shared body, e.g. a memoized result, is copied first.
+    stack.push(std::make_shared<val_func_op>(
+        1,
+        [](gc_heap& a, stack_machine::args_view args)->value_ {
+            return tess::unshare(a, args[0]);
+        },
+        "<unshare>"
+    ));
+    stack.push(body.pop_all());
+    stack.push(std::make_shared<push_frame_op>(scope.frame_size()));
+    scope.pop_frame();
 }
 
 std::string tess::with_expr::to_string() const
@@ -76,11 +89,11 @@ tess::field_definitions::field_definitions(const std::vector<field_def>& defs_wi
     impl_ = std::make_shared<std::vector<field_def_pair>>(defs);
 }
 
-void tess::field_definitions::compile(stack_machine::stack& stack) const
+void tess::field_definitions::compile(stack_machine::stack& stack, stack_machine::scope& scope) const
 {
     for (auto i = impl_->rbegin(); i != impl_->rend(); ++i) {
         const auto& fd = *i;
-        compile_field_def(stack, fd);
+        compile_field_def(stack, scope, fd);
     }
 }
 
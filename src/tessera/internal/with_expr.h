@@ -15,7 +15,7 @@ namespace tess {
 		field_definitions() {}
 		field_definitions(const std::vector<field_def>& defs);
 		field_definitions(const std::vector<field_def_pair>& defs);
-		void compile(stack_machine::stack& stack) const;
+		void compile(stack_machine::stack& stack, stack_machine::scope& scope) const;
 		std::string to_string() const;
 		bool operator!=(const field_definitions& block) { return impl_.get() != block.impl_.get(); }
 		field_definitions simplify() const;
@@ -36,7 +36,7 @@ namespace tess {
 	public:
 		with_expr(const field_definitions& field_defs, expr_ptr body);
 		with_expr(with_expr_params params);
-		void compile(stack_machine::stack& stack) const override;
+		void compile(stack_machine::stack& stack, stack_machine::scope& scope) const override;
 		std::string to_string() const override;
 		expr_ptr simplify() const override;
 		void get_dependencies(std::unordered_set<std::string>& dependencies) const override;
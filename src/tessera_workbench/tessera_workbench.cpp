@@ -13,7 +13,7 @@
 #include <numeric>
 
 std::string read_file(const std::string& file_path); 
-std::tuple<std::string, std::string, std::vector<std::string>> get_arguments(int argc, char** argv);
+std::tuple<std::string, std::string, std::string, bool, std::vector<std::string>> get_arguments(int argc, char** argv);
 void generate_svg(const std::string& filename, const std::vector<tess::tile>& tiles, float scale);
 std::string generate_output_filename(const std::string& filename, const std::string& out_dir);
 std::string args_to_string(std::vector<std::string> args);
@@ -30,7 +30,7 @@ namespace {
 
 int main(int argc, char** argv){
 
-	auto [script_file_path, output_directory, tessera_args] = get_arguments(argc, argv);
+	auto [script_file_path, output_directory, memo_file, parallel, tessera_args] = get_arguments(argc, argv);
 	auto script_name = fs::path(script_file_path).filename().string();
 	std::string source_code = read_file(script_file_path);
 
@@ -45,6 +45,9 @@ int main(int argc, char** argv){
 	}
 
 	const auto& tessera = std::get<tess::script>(results);
+	if (!memo_file.empty())
+		tessera.set_memo_file(memo_file);
+	tessera.set_parallel(parallel);
 		
 	std::cout << "executing " << script_name << " on " << args_to_string(tessera_args) << "...\n";
 
@@ -73,6 +76,12 @@ int main(int argc, char** argv){
 	std::cout << "         execution time: " << exec_duration << "\n";
 	std::cout << " output extraction time: " << output_extraction_duration << "\n";
 	std::cout << "                  total: " << exec_duration + output_extraction_duration << "\n";
+
+	if (!memo_file.empty()) {
+		auto stats = tessera.memo_statistics();
+		std::cout << "\n           memo hits: " << stats.hits << " (" << stats.loaded << " from " << memo_file << ")\n";
+		std::cout << "         memo misses: " << stats.misses << "\n";
+	}
 }
 
 std::string read_file(const std::string& file_path) {
@@ -83,7 +92,8 @@ std::string read_file(const std::string& file_path) {
 	);
 }
 
-std::tuple<std::string, std::string, std::vector<std::string>> get_arguments(int argc, char** argv) {
+// script output_directory [--memo-file path] [--parallel] args...
+std::tuple<std::string, std::string, std::string, bool, std::vector<std::string>> get_arguments(int argc, char** argv) {
 	std::vector<std::string> args;
 	if (argc < 2)
 		return {};
@@ -91,7 +101,21 @@ std::tuple<std::string, std::string, std::vector<std::string>> get_arguments(int
 		args.resize(argc - 1);
 		std::copy(argv + 1, argv + argc, args.begin() );
 	}
-	return { args[0], args[1], std::vector<std::string>(args.begin()+2,args.end()) };
+	auto rest = args.begin() + 2;
+	std::string memo_file;
+	bool parallel = false;
+	while (rest != args.end()) {
+		if (args.end() - rest >= 2 && *rest == "--memo-file") {
+			memo_file = *(rest + 1);
+			rest += 2;
+		} else if (*rest == "--parallel") {
+			parallel = true;
+			++rest;
+		} else {
+			break;
+		}
+	}
+	return { args[0], args[1], memo_file, parallel, std::vector<std::string>(rest, args.end()) };
 }
 
 std::tuple<double, double, double, double> get_bounds(const std::vector<tess::tile>& tiles, float scale) {